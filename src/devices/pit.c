@@ -14,6 +14,13 @@
 /* PIT cycles per second. */
 #define PIT_HZ 1193180
 
+/* Largest count that can be loaded in a one-shot mode.  (A count
+   of 0 would mean 65536, but keeping counts below that saves us
+   from special-casing it.) */
+#define PIT_MAX_COUNT 65535
+
+static uint16_t frequency_to_count (int frequency);
+
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -39,7 +46,8 @@
        it is 1, for the second half it is 0.  This is useful for
        generating a tone on a speaker.
 
-     - Other modes are less useful.
+     - Other modes are less useful here, except for mode 0,
+       which pit_start_oneshot() uses for a single interrupt.
 
    FREQUENCY is the number of periods per second, in Hz. */
 void
@@ -51,16 +59,95 @@ pit_configure_channel (int channel, int mode, int frequency)
   ASSERT (channel == 0 || channel == 2);
   ASSERT (mode == 2 || mode == 3);
 
-  /* Convert FREQUENCY to a PIT counter value.  The PIT has a
-     clock that runs at PIT_HZ cycles per second.  We must
-     translate FREQUENCY into a number of these cycles. */
+  count = frequency_to_count (frequency);
+
+  /* Configure the PIT mode and load its counters. */
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30 | (mode << 1));
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Returns the largest number of periods at FREQUENCY Hz that
+   fit in a single one-shot count.  This is always at least 1,
+   for frequencies that pit_start_oneshot() accepts. */
+int
+pit_max_oneshot (int frequency) 
+{
+  return PIT_MAX_COUNT / frequency_to_count (frequency);
+}
+
+/* Configures CHANNEL in mode 0, "interrupt on terminal count",
+   so that its output rises once, PERIODS periods at FREQUENCY
+   Hz from now, and then stays high until the channel is
+   reconfigured.  Hooked up to channel 0, this yields a single
+   timer interrupt instead of one per period.  FREQUENCY must be
+   at least 19 Hz and PERIODS at most pit_max_oneshot
+   (FREQUENCY). */
+void
+pit_start_oneshot (int channel, int frequency, int periods) 
+{
+  unsigned count;
+  enum intr_level old_level;
+
+  ASSERT (channel == 0 || channel == 2);
+  ASSERT (frequency >= 19);
+  ASSERT (periods > 0 && periods <= pit_max_oneshot (frequency));
+
+  count = frequency_to_count (frequency) * periods;
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30);
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Returns the number of whole periods at FREQUENCY Hz that have
+   elapsed since CHANNEL was started by pit_start_oneshot() with
+   the same FREQUENCY and PERIODS, or PERIODS if the count has
+   run out.  Uses the read-back command to latch the channel's
+   status and count together, because in mode 0 the counter
+   keeps counting down, and wraps around, after it reaches 0:
+   only the output bit in the status says whether it already
+   did. */
+int
+pit_oneshot_elapsed (int channel, int frequency, int periods) 
+{
+  unsigned period_count = frequency_to_count (frequency);
+  enum intr_level old_level;
+  uint8_t status;
+  uint16_t count;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, 0xc0 | (1 << (channel + 1)));
+  status = inb (PIT_PORT_COUNTER (channel));
+  count = inb (PIT_PORT_COUNTER (channel));
+  count |= inb (PIT_PORT_COUNTER (channel)) << 8;
+  intr_set_level (old_level);
+
+  if (status & 0x80)
+    return periods;
+  else
+    return (period_count * periods - count) / period_count;
+}
+
+/* Converts FREQUENCY to a PIT counter value.  The PIT has a
+   clock that runs at PIT_HZ cycles per second.  We must
+   translate FREQUENCY into a number of these cycles. */
+static uint16_t
+frequency_to_count (int frequency) 
+{
   if (frequency < 19)
     {
       /* Frequency is too low: the quotient would overflow the
          16-bit counter.  Force it to 0, which the PIT treats as
          65536, the highest possible count.  This yields a 18.2
          Hz timer, approximately. */
-      count = 0;
+      return 0;
     }
   else if (frequency > PIT_HZ)
     {
@@ -69,15 +156,8 @@ pit_configure_channel (int channel, int mode, int frequency)
          is illegal in mode 2, so we force it to 2, which yields
          a 596.590 kHz timer, approximately.  (This timer rate is
          probably too fast to be useful anyhow.) */
-      count = 2;
+      return 2;
     }
   else
-    count = (PIT_HZ + frequency / 2) / frequency;
-
-  /* Configure the PIT mode and load its counters. */
-  old_level = intr_disable ();
-  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30 | (mode << 1));
-  outb (PIT_PORT_COUNTER (channel), count);
-  outb (PIT_PORT_COUNTER (channel), count >> 8);
-  intr_set_level (old_level);
+    return (PIT_HZ + frequency / 2) / frequency;
 }
@@ -4,5 +4,8 @@
 #include <stdint.h>
 
 void pit_configure_channel (int channel, int mode, int frequency);
+int pit_max_oneshot (int frequency);
+void pit_start_oneshot (int channel, int frequency, int periods);
+int pit_oneshot_elapsed (int channel, int frequency, int periods);
 
 #endif /* devices/pit.h */
@@ -1,6 +1,7 @@
 #include "devices/timer.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stdio.h>
 #include "devices/pit.h"
@@ -20,11 +21,37 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* List of threads blocked in timer_sleep(), in order of
+   increasing wake-up tick.  Threads with equal wake-up ticks
+   are kept in the order in which they went to sleep. */
+static struct list sleep_list;
+
+/* Wake-up tick of the first thread in sleep_list, or INT64_MAX
+   if sleep_list is empty.  Lets timer_interrupt() skip the list
+   entirely on ticks where nobody wakes up. */
+static int64_t next_wakeup;
+
+/* If true, the timer stops ticking periodically while the CPU
+   is idle.  Controlled by kernel command-line option
+   "-tickless". */
+bool timer_tickless;
+
+/* Number of ticks covered by the PIT's current one-shot count,
+   or 0 if the PIT is running periodically. */
+static int oneshot_ticks;
+
+/* Tickless idle statistics. */
+static long long oneshot_cnt;   /* # of one-shot counts started. */
+static long long skipped_ticks; /* # of ticks without an interrupt. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static list_less_func wakeup_less;
+static void wake_sleepers (void);
+static void stop_oneshot (void);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -35,6 +62,9 @@ static void real_time_delay (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
+  list_init (&sleep_list);
+  next_wakeup = INT64_MAX;
+
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -85,15 +115,28 @@ timer_elapsed (int64_t then)
 }
 
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
-   be turned on. */
+   be turned on.
+
+   The calling thread is blocked on sleep_list until the timer
+   interrupt handler finds that its wake-up tick has arrived, so
+   a sleeping thread consumes no CPU time at all. */
 void
 timer_sleep (int64_t ticks) 
 {
-  int64_t start = timer_ticks ();
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  while (timer_elapsed (start) < ticks) 
-    thread_yield ();
+  if (ticks <= 0)
+    return;
+
+  old_level = intr_disable ();
+  cur->wakeup_tick = timer_ticks () + ticks;
+  list_insert_ordered (&sleep_list, &cur->elem, wakeup_less, NULL);
+  if (cur->wakeup_tick < next_wakeup)
+    next_wakeup = cur->wakeup_tick;
+  thread_block ();
+  intr_set_level (old_level);
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -159,21 +202,141 @@ timer_ndelay (int64_t ns)
   real_time_delay (ns, 1000 * 1000 * 1000);
 }
 
+/* Called by the idle thread, with interrupts off, just before
+   it halts the CPU.  In tickless mode, replaces the periodic
+   timer interrupt by a single one at the next sleeper's wake-up
+   tick, or as far ahead as the PIT can count if that is sooner,
+   so that an idle CPU is not woken up on every tick.  The ticks
+   in between are accounted for by stop_oneshot() when the CPU
+   wakes up again, for whatever reason.
+
+   Under the MLFQS, the one-shot never runs past the next whole
+   second, because load_avg and recent_cpu must be updated on
+   exactly that tick. */
+void
+timer_idle (void) 
+{
+  int64_t idle_ticks;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_ticks != 0)
+    return;
+
+  idle_ticks = next_wakeup - ticks;
+  if (idle_ticks > pit_max_oneshot (TIMER_FREQ))
+    idle_ticks = pit_max_oneshot (TIMER_FREQ);
+  if (thread_mlfqs && idle_ticks > TIMER_FREQ - ticks % TIMER_FREQ)
+    idle_ticks = TIMER_FREQ - ticks % TIMER_FREQ;
+  if (idle_ticks < 2)
+    return;
+
+  oneshot_ticks = idle_ticks;
+  oneshot_cnt++;
+  pit_start_oneshot (0, TIMER_FREQ, oneshot_ticks);
+}
+
+/* Called by the scheduler, with interrupts off, when the idle
+   thread gives up the CPU to another thread.  Goes back to
+   periodic ticks, so that the new thread can be preempted. */
+void
+timer_idle_exit (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (oneshot_ticks != 0)
+    stop_oneshot ();
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Timer: %lld ticks skipped while idle, in %lld one-shots\n",
+            skipped_ticks, oneshot_cnt);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
+  if (oneshot_ticks != 0)
+    stop_oneshot ();
   ticks++;
+  if (ticks >= next_wakeup)
+    {
+      wake_sleepers ();
+      thread_preempt ();
+    }
   thread_tick ();
 }
 
+/* Unblocks every thread in sleep_list whose wake-up tick has
+   arrived.  Since the list is sorted, this stops at the first
+   thread that must keep sleeping, so the cost is proportional
+   to the number of threads actually woken.  Must be called with
+   interrupts off. */
+static void
+wake_sleepers (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&sleep_list))
+    {
+      struct thread *t = list_entry (list_front (&sleep_list),
+                                     struct thread, elem);
+      if (t->wakeup_tick > ticks)
+        {
+          next_wakeup = t->wakeup_tick;
+          return;
+        }
+      list_pop_front (&sleep_list);
+      thread_unblock (t);
+    }
+  next_wakeup = INT64_MAX;
+}
+
+/* Returns the PIT to periodic mode after a one-shot count
+   started by timer_idle(), and advances `ticks' by the number of
+   whole ticks that passed without an interrupt.
+
+   If the count ran out, its interrupt is being handled now or
+   is pending, and it stands for the last of the one-shot's
+   ticks, so only the others are added here.  Otherwise the CPU
+   was woken early by another interrupt, and the part of a tick
+   that elapsed since the last whole one is lost: the clock falls
+   behind by less than a tick each time this happens. */
+static void
+stop_oneshot (void) 
+{
+  int elapsed;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (oneshot_ticks != 0);
+
+  elapsed = pit_oneshot_elapsed (0, TIMER_FREQ, oneshot_ticks);
+  if (elapsed == oneshot_ticks)
+    elapsed--;
+  pit_configure_channel (0, 2, TIMER_FREQ);
+  oneshot_ticks = 0;
+
+  ticks += elapsed;
+  skipped_ticks += elapsed;
+}
+
+/* Returns true if thread A_ should wake up before thread B_. */
+static bool
+wakeup_less (const struct list_elem *a_, const struct list_elem *b_,
+             void *aux UNUSED) 
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->wakeup_tick < b->wakeup_tick;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
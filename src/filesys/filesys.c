@@ -21,6 +21,7 @@ filesys_init (bool format)
   if (fs_device == NULL)
     PANIC ("No file system device found, can't initialize file system.");
 
+  file_init ();
   inode_init ();
   free_map_init ();
 
@@ -3,6 +3,7 @@
 #include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include "threads/malloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
@@ -21,13 +22,28 @@ typedef unsigned long elem_type;
 /* Number of bits in an element. */
 #define ELEM_BITS (sizeof (elem_type) * CHAR_BIT)
 
+/* Minimum number of elements for a bitmap to have a summary. */
+#define SUMMARY_MIN_ELEMS 32
+
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Operations on ranges of bits work on whole elements at a
+   time, and searches use the processor's bit scan instruction
+   to find the first interesting bit in an element.  Large
+   bitmaps also have a summary level above the bits, with one
+   bit per element: bit I of HAS[V] is set if element I contains
+   any bit set to V.  So a search for a free bit in a mostly full
+   bitmap, or vice versa, skips ELEM_BITS elements at a time.
+   The summary is brought up to date after each change to the
+   bits, so like the rest of the bitmap it must be protected
+   from concurrent modification by the caller. */
 struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    elem_type *has[2];  /* Summary, or null pointers if none. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -68,6 +84,100 @@ last_mask (const struct bitmap *b)
   int last_bits = b->bit_cnt % ELEM_BITS;
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns the number of elements required for each half of the
+   summary of a bitmap of BIT_CNT bits, which is 0 if such a
+   bitmap has no summary. */
+static inline size_t
+summary_elem_cnt (size_t bit_cnt) 
+{
+  size_t cnt = elem_cnt (bit_cnt);
+  return cnt >= SUMMARY_MIN_ELEMS ? elem_cnt (cnt) : 0;
+}
+
+/* Returns the number of bytes required for the bits and summary
+   of a bitmap of BIT_CNT bits. */
+static inline size_t
+storage_size (size_t bit_cnt) 
+{
+  return (byte_cnt (bit_cnt)
+          + 2 * sizeof (elem_type) * summary_elem_cnt (bit_cnt));
+}
+
+/* Returns an elem_type where the CNT bits starting at bit OFS
+   are turned on, where OFS + CNT <= ELEM_BITS. */
+static inline elem_type
+range_mask (size_t ofs, size_t cnt) 
+{
+  elem_type mask = (cnt < ELEM_BITS
+                    ? ((elem_type) 1 << cnt) - 1
+                    : (elem_type) -1);
+  return mask << ofs;
+}
+
+/* Returns the index of the lowest set bit in nonzero X, using
+   the BSF instruction. */
+static inline size_t
+first_set (elem_type x) 
+{
+  ASSERT (x != 0);
+  return __builtin_ctzl (x);
+}
+
+/* Returns the number of set bits in X.  Our target processors
+   have no POPCNT instruction and we don't link against libgcc,
+   so this adds up bits in parallel instead. */
+static inline size_t
+popcount (elem_type x) 
+{
+  const elem_type ones = -1;
+
+  x = x - ((x >> 1) & ones / 3);
+  x = (x & ones / 15 * 3) + ((x >> 2) & ones / 15 * 3);
+  x = (x + (x >> 4)) & ones / 255 * 15;
+  x *= ones / 255;
+  return x >> (sizeof (elem_type) - 1) * CHAR_BIT;
+}
+
+/* Points B's summary at the storage following its bits and
+   clears it, if B is big enough to have a summary. */
+static void
+init_summary (struct bitmap *b) 
+{
+  size_t cnt = summary_elem_cnt (b->bit_cnt);
+
+  if (cnt > 0) 
+    {
+      b->has[false] = b->bits + elem_cnt (b->bit_cnt);
+      b->has[true] = b->has[false] + cnt;
+      memset (b->has[false], 0, 2 * sizeof (elem_type) * cnt);
+    }
+  else
+    b->has[false] = b->has[true] = NULL;
+}
+
+/* Brings the summary bits for element IDX of B up to date. */
+static void
+update_summary (struct bitmap *b, size_t idx) 
+{
+  elem_type valid, smask;
+  size_t sidx;
+
+  if (b->has[false] == NULL)
+    return;
+
+  valid = idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b) : (elem_type) -1;
+  sidx = elem_idx (idx);
+  smask = bit_mask (idx);
+  if (~b->bits[idx] & valid)
+    b->has[false][sidx] |= smask;
+  else
+    b->has[false][sidx] &= ~smask;
+  if (b->bits[idx] & valid)
+    b->has[true][sidx] |= smask;
+  else
+    b->has[true][sidx] &= ~smask;
+}
 
 /* Creation and destruction. */
 
@@ -82,9 +192,10 @@ bitmap_create (size_t bit_cnt)
   if (b != NULL)
     {
       b->bit_cnt = bit_cnt;
-      b->bits = malloc (byte_cnt (bit_cnt));
+      b->bits = malloc (storage_size (bit_cnt));
       if (b->bits != NULL || bit_cnt == 0)
         {
+          init_summary (b);
           bitmap_set_all (b, false);
           return b;
         }
@@ -105,6 +216,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  init_summary (b);
   bitmap_set_all (b, false);
   return b;
 }
@@ -114,7 +226,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 size_t
 bitmap_buf_size (size_t bit_cnt) 
 {
-  return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+  return sizeof (struct bitmap) + storage_size (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -141,7 +253,7 @@ bitmap_size (const struct bitmap *b)
 
 /* Setting and testing single bits. */
 
-/* Atomically sets the bit numbered IDX in B to VALUE. */
+/* Sets the bit numbered IDX in B to VALUE. */
 void
 bitmap_set (struct bitmap *b, size_t idx, bool value) 
 {
@@ -153,7 +265,11 @@ bitmap_set (struct bitmap *b, size_t idx, bool value)
     bitmap_reset (b, idx);
 }
 
-/* Atomically sets the bit numbered BIT_IDX in B to true. */
+/* Sets the bit numbered BIT_IDX in B to true.  The bit itself
+   is set atomically, but if B is large enough to have a summary,
+   bringing the summary up to date is a separate step, so the
+   caller must still keep others from modifying B at the same
+   time. */
 void
 bitmap_mark (struct bitmap *b, size_t bit_idx) 
 {
@@ -164,9 +280,11 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the OR instruction in [IA32-v2b]. */
   asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
-/* Atomically sets the bit numbered BIT_IDX in B to false. */
+/* Sets the bit numbered BIT_IDX in B to false.  See
+   bitmap_mark() about atomicity. */
 void
 bitmap_reset (struct bitmap *b, size_t bit_idx) 
 {
@@ -177,11 +295,13 @@ bitmap_reset (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
   asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  update_summary (b, idx);
 }
 
-/* Atomically toggles the bit numbered IDX in B;
+/* Toggles the bit numbered IDX in B;
    that is, if it is true, makes it false,
-   and if it is false, makes it true. */
+   and if it is false, makes it true.
+   See bitmap_mark() about atomicity. */
 void
 bitmap_flip (struct bitmap *b, size_t bit_idx) 
 {
@@ -192,6 +312,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -214,18 +335,33 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.  Neither
+   the range as a whole nor, if B has a summary, each element is
+   updated atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  size_t end = start + cnt;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  while (start < end) 
+    {
+      size_t idx = elem_idx (start);
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+      elem_type mask = range_mask (ofs, n);
+
+      /* See bitmap_mark() and bitmap_reset(). */
+      if (value)
+        asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+      update_summary (b, idx);
+      start += n;
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -233,16 +369,24 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i, value_cnt;
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t end = start + cnt;
+  size_t value_cnt;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
+  while (start < end) 
+    {
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+
+      value_cnt += popcount ((b->bits[elem_idx (start)] ^ flip)
+                             & range_mask (ofs, n));
+      start += n;
+    }
   return value_cnt;
 }
 
@@ -251,15 +395,22 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t end = start + cnt;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
+  while (start < end) 
+    {
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+
+      if ((b->bits[elem_idx (start)] ^ flip) & range_mask (ofs, n))
+        return true;
+      start += n;
+    }
   return false;
 }
 
@@ -289,6 +440,62 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt)
 
 /* Finding set or unset bits. */
 
+/* Returns the index of the first element of B at or after IDX
+   that may contain a bit set to VALUE, according to B's
+   summary, or the number of elements in B if there is none.
+   Without a summary, returns IDX. */
+static size_t
+next_elem (const struct bitmap *b, size_t idx, bool value) 
+{
+  size_t cnt = elem_cnt (b->bit_cnt);
+  const elem_type *has = b->has[value];
+  size_t sidx;
+  elem_type word;
+
+  if (has == NULL || idx >= cnt)
+    return idx;
+
+  sidx = elem_idx (idx);
+  word = has[sidx] & ~(bit_mask (idx) - 1);
+  while (word == 0) 
+    {
+      if (++sidx >= elem_cnt (cnt))
+        return cnt;
+      word = has[sidx];
+    }
+  idx = sidx * ELEM_BITS + first_set (word);
+  return idx < cnt ? idx : cnt;
+}
+
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or the number of bits in B if there is none. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) 
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t cnt = elem_cnt (b->bit_cnt);
+  size_t idx, bit_idx;
+  elem_type word;
+
+  if (start >= b->bit_cnt)
+    return b->bit_cnt;
+
+  idx = elem_idx (start);
+  word = (b->bits[idx] ^ flip) & ~(bit_mask (start) - 1);
+  while (word == 0) 
+    {
+      idx = next_elem (b, idx + 1, value);
+      if (idx >= cnt)
+        return b->bit_cnt;
+      word = b->bits[idx] ^ flip;
+    }
+
+  /* The unused bits at the end of the last element are 0, so
+     they can be found when VALUE is false. */
+  bit_idx = idx * ELEM_BITS + first_set (word);
+  return bit_idx < b->bit_cnt ? bit_idx : b->bit_cnt;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
@@ -302,10 +509,25 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      if (cnt == 0)
+        return start <= last ? start : BITMAP_ERROR;
+
+      /* Jump from each run of bits set to VALUE to the next,
+         until one is long enough. */
+      while (i <= last) 
+        {
+          size_t run_start = find_next (b, i, value);
+          size_t run_end;
+
+          if (run_start > last)
+            break;
+          run_end = find_next (b, run_start, !value);
+          if (run_end - run_start >= cnt)
+            return run_start;
+          i = run_end;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -315,8 +537,7 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
    and returns the index of the first bit in the group.
    If there is no such group, returns BITMAP_ERROR.
    If CNT is zero, returns 0.
-   Bits are set atomically, but testing bits is not atomic with
-   setting them. */
+   Testing bits is not atomic with setting them. */
 size_t
 bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)
 {
@@ -345,8 +566,12 @@ bitmap_read (struct bitmap *b, struct file *file)
   if (b->bit_cnt > 0) 
     {
       off_t size = byte_cnt (b->bit_cnt);
+      size_t i;
+
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+        update_summary (b, i);
     }
   return success;
 }
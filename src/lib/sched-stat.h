@@ -0,0 +1,23 @@
+#ifndef __LIB_SCHED_STAT_H
+#define __LIB_SCHED_STAT_H
+
+/* Per-thread scheduler statistics, shared between the kernel
+   and user programs through the schedstat system call. */
+
+/* Number of buckets in a run-queue wait histogram.  Bucket 0
+   counts waits of 0 timer ticks, bucket B (for 0 < B <
+   SCHED_WAIT_BUCKETS - 1) counts waits of 2**(B-1) through
+   2**B - 1 ticks, and the last bucket counts all longer waits. */
+#define SCHED_WAIT_BUCKETS 12
+
+/* Scheduler statistics for one thread. */
+struct sched_stat
+  {
+    long long run_ticks;        /* Timer ticks spent running. */
+    long long ready_ticks;      /* Timer ticks spent ready, not running. */
+    unsigned voluntary_switches;   /* Switches away while blocking. */
+    unsigned involuntary_switches; /* Switches away while runnable. */
+    unsigned wait_hist[SCHED_WAIT_BUCKETS]; /* Run-queue wait histogram. */
+  };
+
+#endif /* lib/sched-stat.h */
@@ -182,3 +182,9 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+schedstat (pid_t pid, struct sched_stat *stat)
+{
+  return syscall2 (SYS_SCHEDSTAT, pid, stat);
+}
@@ -0,0 +1,113 @@
+/* Measures how much CPU time is lost to a large number of
+   sleeping threads.
+
+   The main thread first spins for a fixed number of ticks with
+   no other threads around and counts how many loop iterations
+   it completes.  Then it creates SLEEPER_CNT threads that all
+   sleep past the end of a second measurement window of the same
+   length, spins again, and compares the two counts.  Sleeping
+   threads should be blocked, not polling, so the main thread
+   should get nearly all of the CPU in both windows. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of concurrently sleeping threads. */
+#define SLEEPER_CNT 128
+
+/* Length of each measurement window, in timer ticks. */
+#define WINDOW_TICKS 50
+
+/* Minimum acceptable loaded/unloaded throughput, in percent. */
+#define MIN_PERCENT 75
+
+/* Information about the test. */
+struct sleeper_test
+  {
+    int64_t wakeup;             /* Tick at which sleepers wake up. */
+    struct semaphore done;      /* Upped by each sleeper on wake-up. */
+    int early_cnt;              /* Sleepers that woke up too soon. */
+  };
+
+static void sleeper (void *);
+static long long spin (int64_t ticks);
+
+void
+test_alarm_sleepers (void)
+{
+  struct sleeper_test test;
+  long long unloaded, loaded;
+  int percent;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Measuring CPU available with %d sleeping threads.", SLEEPER_CNT);
+
+  unloaded = spin (WINDOW_TICKS);
+
+  /* Give the sleepers enough time to be created and to fall
+     asleep before the second window begins, and make them sleep
+     well past its end. */
+  sema_init (&test.done, 0);
+  test.early_cnt = 0;
+  test.wakeup = timer_ticks () + WINDOW_TICKS * 3;
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, &test) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+  timer_sleep (WINDOW_TICKS / 2);
+
+  loaded = spin (WINDOW_TICKS);
+
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&test.done);
+  if (test.early_cnt != 0)
+    fail ("%d sleepers woke up early", test.early_cnt);
+
+  percent = unloaded > 0 ? loaded * 100 / unloaded : 0;
+  msg ("Unloaded: %lld iterations in %d ticks.", unloaded, WINDOW_TICKS);
+  msg ("Loaded: %lld iterations in %d ticks (%d%%).",
+       loaded, WINDOW_TICKS, percent);
+  if (percent < MIN_PERCENT)
+    fail ("sleeping threads consumed %d%% of the CPU", 100 - percent);
+  pass ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *test_)
+{
+  struct sleeper_test *test = test_;
+
+  timer_sleep (test->wakeup - timer_ticks ());
+  if (timer_ticks () < test->wakeup)
+    test->early_cnt++;
+  sema_up (&test->done);
+}
+
+/* Waits for the start of a tick, then busy-loops for TICKS
+   ticks and returns the number of iterations completed. */
+static long long
+spin (int64_t ticks)
+{
+  int64_t start, end;
+  long long iterations = 0;
+
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+  end = start + 1 + ticks;
+  while (timer_ticks () < end)
+    iterations++;
+  return iterations;
+}
@@ -0,0 +1,40 @@
+/* Runs with the timer in tickless mode and checks that sleeping
+   threads still wake up on time.  While the main thread sleeps,
+   nothing else is ready to run, so the idle thread replaces the
+   periodic timer interrupt by a one-shot one at the wake-up
+   tick.  The longer sleeps span more ticks than a single
+   one-shot count can, so they also check that one-shots are
+   chained correctly. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+void
+test_alarm_tickless (void) 
+{
+  static const int durations[] = {1, 2, 3, 5, 8, 13, 21, 34};
+  size_t i;
+
+  ASSERT (timer_tickless);
+
+  for (i = 0; i < sizeof durations / sizeof *durations; i++)
+    {
+      int64_t start = timer_ticks ();
+      int64_t elapsed;
+
+      msg ("Sleeping %d ticks.", durations[i]);
+      timer_sleep (durations[i]);
+
+      /* A tick may pass between reading the time and going to
+         sleep, so allow one extra tick. */
+      elapsed = timer_elapsed (start);
+      if (elapsed < durations[i] || elapsed > durations[i] + 1)
+        fail ("slept %lld ticks instead of %d",
+              (long long) elapsed, durations[i]);
+    }
+  pass ();
+}
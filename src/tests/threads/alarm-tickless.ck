@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) Sleeping 1 ticks.
+(alarm-tickless) Sleeping 2 ticks.
+(alarm-tickless) Sleeping 3 ticks.
+(alarm-tickless) Sleeping 5 ticks.
+(alarm-tickless) Sleeping 8 ticks.
+(alarm-tickless) Sleeping 13 ticks.
+(alarm-tickless) Sleeping 21 ticks.
+(alarm-tickless) Sleeping 34 ticks.
+(alarm-tickless) PASS
+(alarm-tickless) end
+EOF
+
+my ($skipped) = map (/^Timer: (\d+) ticks skipped while idle/, @output);
+fail "missing tickless timer statistics\n" unless defined $skipped;
+fail "no ticks were skipped while idle\n" unless $skipped > 0;
+pass;
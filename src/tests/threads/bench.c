@@ -0,0 +1,17 @@
+/* Timing shared by the benchmark tests. */
+
+#include "tests/threads/bench.h"
+#include "devices/timer.h"
+
+/* Waits for the start of a tick and returns it.  A measurement
+   window that starts there and runs until BENCH_WINDOW_TICKS
+   later lasts the full number of ticks. */
+int64_t
+bench_start_window (void) 
+{
+  int64_t start = timer_ticks ();
+
+  while (timer_ticks () == start)
+    continue;
+  return start + 1;
+}
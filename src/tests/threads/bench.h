@@ -0,0 +1,11 @@
+#ifndef TESTS_THREADS_BENCH_H
+#define TESTS_THREADS_BENCH_H
+
+#include <stdint.h>
+
+/* Length of each benchmark measurement window, in timer ticks. */
+#define BENCH_WINDOW_TICKS 20
+
+int64_t bench_start_window (void);
+
+#endif /* tests/threads/bench.h */
@@ -0,0 +1,14 @@
+sub check_bench {
+    our ($test);
+    my ($name) = $test =~ m%([^/]+)$%;
+
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+
+    @output = get_core_output ("run", @output);
+    fail "missing PASS in output"
+      unless grep ($_ eq "($name) PASS", @output);
+    pass;
+}
+
+1;
@@ -0,0 +1,109 @@
+/* Measures bitmap_scan() on a bitmap the size of the free map of
+   a 1 GB disk, that is, one bit for each of 2,097,152 sectors,
+   in two fragmented states: with a single free bit every 37
+   bits, and with a single free bit every 4,096 bits.  In both,
+   the only run of 16 free bits is near the end, neither touching
+   nor overlapping any of the single free bits.
+
+   Each scan for that run is timed against a simple bit-by-bit
+   scan, which is also used to check the result.  The numbers
+   depend on the machine, so the test only checks that the
+   results agree. */
+
+#include <bitmap.h>
+#include <stdio.h>
+#include "tests/threads/bench.h"
+#include "tests/threads/tests.h"
+#include "devices/timer.h"
+
+/* Number of bits: one per sector of a 1 GB disk. */
+#define BIT_CNT (1024 * 1024 * 1024 / 512)
+
+/* Length and position of the run to find. */
+#define RUN_CNT 16
+#define RUN_START (BIT_CNT - 100)
+
+static void fragment (struct bitmap *, size_t spacing);
+static size_t slow_scan (const struct bitmap *, size_t cnt);
+static void measure (const struct bitmap *, size_t spacing);
+
+void
+test_bitmap_bench (void) 
+{
+  struct bitmap *b = bitmap_create (BIT_CNT);
+  if (b == NULL)
+    fail ("couldn't create %d-bit bitmap", BIT_CNT);
+
+  fragment (b, 37);
+  measure (b, 37);
+  fragment (b, 4096);
+  measure (b, 4096);
+
+  bitmap_destroy (b);
+  pass ();
+}
+
+/* Marks every bit in B as used except one in every SPACING and
+   a run of RUN_CNT bits at RUN_START. */
+static void
+fragment (struct bitmap *b, size_t spacing) 
+{
+  size_t i;
+
+  bitmap_set_all (b, true);
+  for (i = 0; i < BIT_CNT; i += spacing)
+    bitmap_reset (b, i);
+  bitmap_set_multiple (b, RUN_START, RUN_CNT, false);
+}
+
+/* Times scans of B for RUN_CNT free bits, after checking that
+   bitmap_scan() and slow_scan() agree. */
+static void
+measure (const struct bitmap *b, size_t spacing) 
+{
+  long long fast_cnt = 0, slow_cnt = 0;
+  size_t fast, slow;
+  int64_t end;
+
+  fast = bitmap_scan (b, 0, RUN_CNT, false);
+  slow = slow_scan (b, RUN_CNT);
+  if (fast != slow || fast != RUN_START)
+    fail ("bitmap_scan() returned %zu, bit-by-bit scan %zu, expected %d",
+          fast, slow, RUN_START);
+  if (bitmap_count (b, 0, BIT_CNT, false)
+      != (BIT_CNT - 1) / spacing + 1 + RUN_CNT)
+    fail ("bitmap_count() returned wrong count");
+
+  end = bench_start_window () + BENCH_WINDOW_TICKS;
+  while (timer_ticks () < end) 
+    {
+      bitmap_scan (b, 0, RUN_CNT, false);
+      fast_cnt++;
+    }
+  end = bench_start_window () + BENCH_WINDOW_TICKS;
+  while (timer_ticks () < end) 
+    {
+      slow_scan (b, RUN_CNT);
+      slow_cnt++;
+    }
+
+  msg ("Free bit every %zu: %lld scans in %d ticks, "
+       "%lld bit-by-bit scans.", spacing, fast_cnt, BENCH_WINDOW_TICKS,
+       slow_cnt);
+}
+
+/* Returns the first run of CNT false bits in B, testing one bit
+   at a time, or BITMAP_ERROR if there is none. */
+static size_t
+slow_scan (const struct bitmap *b, size_t cnt) 
+{
+  size_t run = 0;
+  size_t i;
+
+  for (i = 0; i < bitmap_size (b); i++)
+    if (bitmap_test (b, i))
+      run = 0;
+    else if (++run == cnt)
+      return i + 1 - cnt;
+  return BITMAP_ERROR;
+}
@@ -0,0 +1,65 @@
+/* Checks that a thread signaled through a condition variable
+   wakes up only once, when it gets the lock.
+
+   The main thread creates several higher-priority threads that
+   wait on a condition variable, then acquires the lock and
+   broadcasts the condition.  The waiters cannot run while the
+   main thread holds the lock, so if they were woken up by the
+   broadcast they would immediately block again on the lock.
+   Instead, each waiter should block exactly once in cond_wait():
+   the broadcast should move it directly onto the lock's wait
+   queue, from which it is woken up in priority order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of waiting threads. */
+#define WAITER_CNT 5
+
+static thread_func waiter_thread;
+static struct lock lock;
+static struct condition condition;
+
+void
+test_condvar_morph (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  cond_init (&condition);
+
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i, waiter_thread, NULL);
+    }
+
+  lock_acquire (&lock);
+  msg ("Broadcasting...");
+  cond_broadcast (&condition, &lock);
+  msg ("Releasing the lock.");
+  lock_release (&lock);
+  msg ("All waiters must already have woken up.");
+}
+
+static void
+waiter_thread (void *aux UNUSED) 
+{
+  struct sched_stat before, after;
+  unsigned blocks;
+
+  lock_acquire (&lock);
+  thread_get_stat (thread_current (), &before);
+  cond_wait (&condition, &lock);
+  thread_get_stat (thread_current (), &after);
+  blocks = after.voluntary_switches - before.voluntary_switches;
+  msg ("%s woke up after blocking %u time(s).", thread_name (), blocks);
+  lock_release (&lock);
+}
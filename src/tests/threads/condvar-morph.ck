@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(condvar-morph) begin
+(condvar-morph) Broadcasting...
+(condvar-morph) Releasing the lock.
+(condvar-morph) waiter 4 woke up after blocking 1 time(s).
+(condvar-morph) waiter 3 woke up after blocking 1 time(s).
+(condvar-morph) waiter 2 woke up after blocking 1 time(s).
+(condvar-morph) waiter 1 woke up after blocking 1 time(s).
+(condvar-morph) waiter 0 woke up after blocking 1 time(s).
+(condvar-morph) All waiters must already have woken up.
+(condvar-morph) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Checks the kernel heap usage report printed under
+   "-heapstat".  Leaks 7 blocks of 1,000 bytes from one call
+   site and 3 pages from another, and allocates and frees more
+   blocks from a third.  The report itself is printed at
+   shutdown and checked by heap-stat.ck, which expects the two
+   leaking call sites to be among those listed, and the third
+   not to be. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/heapstat.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+
+/* Number of blocks and pages to leak. */
+#define LEAK_BLOCKS 7
+#define LEAK_PAGES 3
+
+void
+test_heap_stat (void) 
+{
+  int i;
+
+  ASSERT (heapstat);
+
+  for (i = 0; i < LEAK_BLOCKS; i++)
+    if (malloc (1000) == NULL)
+      fail ("malloc failed");
+  for (i = 0; i < LEAK_PAGES; i++)
+    if (palloc_get_page (0) == NULL)
+      fail ("palloc_get_page failed");
+  for (i = 0; i < 100; i++)
+    free (malloc (3000));
+  msg ("Leaked %d blocks and %d pages.", LEAK_BLOCKS, LEAK_PAGES);
+}
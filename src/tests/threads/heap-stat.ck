@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+check_expected ([<<'EOF']);
+(heap-stat) begin
+(heap-stat) Leaked 7 blocks and 3 pages.
+(heap-stat) end
+EOF
+
+fail "missing heap usage summary\n"
+  unless grep (/^Heap: \d+ bytes in \d+ live allocations, peak \d+ bytes, \d+ not tracked$/, @output);
+fail "missing leaked malloc() blocks\n"
+  unless grep (/^Heap: 0x[0-9a-f]{8}: 7168 bytes in 7 live allocations, 7 total$/, @output);
+fail "missing leaked pages\n"
+  unless grep (/^Heap: 0x[0-9a-f]{8}: 12288 bytes in 3 live allocations, 3 total$/, @output);
+fail "freed blocks reported as live\n"
+  if grep (/^Heap: 0x[0-9a-f]{8}: \d+ bytes in \d+ live allocations, 100 total$/, @output);
+pass;
@@ -0,0 +1,44 @@
+/* Checks the contention statistics kept for a named lock under
+   "-lockstat".  The main thread acquires the lock and creates
+   two higher-priority threads that block acquiring it, so that
+   the lock ends up acquired 3 times, 2 of which are contended.
+   The statistics themselves are printed at shutdown and checked
+   by lock-stat.ck. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func acquire_thread_func;
+
+/* A named lock must never be destroyed, so it cannot live on
+   the stack. */
+static struct lock lock;
+
+void
+test_lock_stat (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  ASSERT (lockstat);
+
+  lock_init_named (&lock, "lock-stat");
+  lock_acquire (&lock);
+  thread_create ("acquire1", PRI_DEFAULT + 1, acquire_thread_func, NULL);
+  thread_create ("acquire2", PRI_DEFAULT + 2, acquire_thread_func, NULL);
+  timer_sleep (5);
+  lock_release (&lock);
+  msg ("acquire2, acquire1 must already have finished, in that order.");
+}
+
+static void
+acquire_thread_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("%s: got the lock", thread_name ());
+  lock_release (&lock);
+}
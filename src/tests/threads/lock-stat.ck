@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+check_expected ([<<'EOF']);
+(lock-stat) begin
+(lock-stat) acquire2: got the lock
+(lock-stat) acquire1: got the lock
+(lock-stat) acquire2, acquire1 must already have finished, in that order.
+(lock-stat) end
+EOF
+
+my ($stat) = grep (/^Lock lock-stat: /, @output);
+fail "missing statistics for lock-stat\n" unless defined $stat;
+my ($acquires, $contended, $waited, $held)
+  = $stat =~ /^Lock lock-stat: (\d+) acquires, (\d+) contended, (\d+) ticks waited, (\d+) ticks max hold$/
+  or fail "malformed lock statistics: $stat\n";
+fail "expected 3 acquires, got $acquires\n" if $acquires != 3;
+fail "expected 2 contended acquires, got $contended\n" if $contended != 2;
+fail "expected at least 10 ticks waited, got $waited\n" if $waited < 10;
+fail "expected at least 5 ticks max hold, got $held\n" if $held < 5;
+pass;
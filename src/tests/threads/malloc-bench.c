@@ -0,0 +1,88 @@
+/* Measures malloc() and free() throughput for a few block
+   sizes, in two patterns: a block freed right after it is
+   allocated, which should be served from the descriptor's
+   magazine, and bursts of blocks too large for the magazine to
+   absorb, which must go through the descriptor's free list.
+
+   The numbers depend on the machine, so the test only checks
+   that the allocator keeps working and that each pattern makes
+   progress. */
+
+#include <stdio.h>
+#include "tests/threads/bench.h"
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+
+/* Number of blocks allocated in each burst. */
+#define BURST_CNT 64
+
+static long long measure_pairs (size_t size);
+static long long measure_bursts (size_t size);
+
+void
+test_malloc_bench (void) 
+{
+  static const size_t sizes[] = {16, 100, 600};
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      long long pairs = measure_pairs (sizes[i]);
+      long long bursts = measure_bursts (sizes[i]);
+
+      msg ("%zu bytes: %lld alloc/free pairs, %lld burst blocks per tick.",
+           sizes[i], pairs / BENCH_WINDOW_TICKS,
+           bursts / BENCH_WINDOW_TICKS);
+      if (pairs == 0 || bursts == 0)
+        fail ("no progress for %zu-byte blocks", sizes[i]);
+    }
+  pass ();
+}
+
+/* Returns the number of SIZE-byte blocks allocated and freed one
+   at a time in a measurement window. */
+static long long
+measure_pairs (size_t size) 
+{
+  int64_t end = bench_start_window () + BENCH_WINDOW_TICKS;
+  long long cnt = 0;
+
+  while (timer_ticks () < end) 
+    {
+      char *p = malloc (size);
+      if (p == NULL)
+        fail ("malloc (%zu) failed", size);
+      p[0] = p[size - 1] = 1;
+      free (p);
+      cnt++;
+    }
+  return cnt;
+}
+
+/* Returns the number of SIZE-byte blocks allocated and freed in
+   bursts of BURST_CNT in a measurement window. */
+static long long
+measure_bursts (size_t size) 
+{
+  int64_t end = bench_start_window () + BENCH_WINDOW_TICKS;
+  long long cnt = 0;
+
+  while (timer_ticks () < end) 
+    {
+      char *p[BURST_CNT];
+      int i;
+
+      for (i = 0; i < BURST_CNT; i++) 
+        {
+          p[i] = malloc (size);
+          if (p[i] == NULL)
+            fail ("malloc (%zu) failed", size);
+          p[i][0] = p[i][size - 1] = 1;
+        }
+      for (i = 0; i < BURST_CNT; i++)
+        free (p[i]);
+      cnt += BURST_CNT;
+    }
+  return cnt;
+}
@@ -0,0 +1,84 @@
+/* Checks that realloc() grows and shrinks mid-size blocks in
+   place when the space that follows them is free, and that it
+   preserves block contents whether or not it moves them. */
+
+#include <stdint.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+
+static void fill (uint8_t *, size_t size, uint8_t seed);
+static void check (const uint8_t *, size_t size, uint8_t seed);
+
+void
+test_malloc_realloc (void) 
+{
+  uint8_t *p, *q;
+
+  /* Shrinking a mid-size block is always possible in place. */
+  p = malloc (8000);
+  if (p == NULL)
+    fail ("malloc (8000) failed");
+  fill (p, 8000, 1);
+  q = realloc (p, 3000);
+  if (q != p)
+    fail ("shrinking a mid-size block moved it");
+  check (q, 3000, 1);
+  msg ("Shrank a mid-size block in place.");
+
+  /* The units the block just gave back follow it, whatever else
+     the run holds, so it can grow into them again. */
+  p = realloc (q, 6000);
+  if (p != q)
+    fail ("growing a mid-size block moved it");
+  check (p, 3000, 1);
+  msg ("Grew a mid-size block in place.");
+  fill (p, 6000, 2);
+
+  /* Shrinking it to a small block moves it. */
+  q = realloc (p, 100);
+  if (q == NULL)
+    fail ("realloc (100) failed");
+  check (q, 100, 2);
+  msg ("Moved a mid-size block to a small one.");
+
+  /* Big blocks keep their contents however they are resized. */
+  fill (q, 100, 3);
+  p = realloc (q, 20000);
+  if (p == NULL)
+    fail ("realloc (20000) failed");
+  check (p, 100, 3);
+  fill (p, 20000, 4);
+  q = realloc (p, 40000);
+  if (q == NULL)
+    fail ("realloc (40000) failed");
+  check (q, 20000, 4);
+  p = realloc (q, 24000);
+  if (p != q)
+    fail ("shrinking a big block moved it");
+  check (p, 24000, 4);
+  msg ("Resized a big block.");
+
+  free (p);
+}
+
+/* Fills the SIZE bytes at P with a pattern derived from SEED. */
+static void
+fill (uint8_t *p, size_t size, uint8_t seed) 
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    p[i] = i * 7 + seed;
+}
+
+/* Checks that the SIZE bytes at P hold the pattern written by
+   fill() with SEED. */
+static void
+check (const uint8_t *p, size_t size, uint8_t seed) 
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != (uint8_t) (i * 7 + seed))
+      fail ("byte %zu is %d, expected %d", i, p[i], (uint8_t) (i * 7 + seed));
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-realloc) begin
+(malloc-realloc) Shrank a mid-size block in place.
+(malloc-realloc) Grew a mid-size block in place.
+(malloc-realloc) Moved a mid-size block to a small one.
+(malloc-realloc) Resized a big block.
+(malloc-realloc) end
+EOF
+pass;
@@ -0,0 +1,86 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-deep) begin
+(priority-donate-deep) main got lock.
+(priority-donate-deep) main should have priority 3.  Actual priority: 3.
+(priority-donate-deep) main should have priority 6.  Actual priority: 6.
+(priority-donate-deep) main should have priority 9.  Actual priority: 9.
+(priority-donate-deep) main should have priority 12.  Actual priority: 12.
+(priority-donate-deep) main should have priority 15.  Actual priority: 15.
+(priority-donate-deep) main should have priority 18.  Actual priority: 18.
+(priority-donate-deep) main should have priority 21.  Actual priority: 21.
+(priority-donate-deep) main should have priority 24.  Actual priority: 24.
+(priority-donate-deep) main should have priority 27.  Actual priority: 27.
+(priority-donate-deep) main should have priority 30.  Actual priority: 30.
+(priority-donate-deep) main should have priority 33.  Actual priority: 33.
+(priority-donate-deep) main should have priority 36.  Actual priority: 36.
+(priority-donate-deep) main should have priority 39.  Actual priority: 39.
+(priority-donate-deep) main should have priority 42.  Actual priority: 42.
+(priority-donate-deep) main should have priority 45.  Actual priority: 45.
+(priority-donate-deep) thread 1 got lock
+(priority-donate-deep) thread 1 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 2 got lock
+(priority-donate-deep) thread 2 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 3 got lock
+(priority-donate-deep) thread 3 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 4 got lock
+(priority-donate-deep) thread 4 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 5 got lock
+(priority-donate-deep) thread 5 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 6 got lock
+(priority-donate-deep) thread 6 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 7 got lock
+(priority-donate-deep) thread 7 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 8 got lock
+(priority-donate-deep) thread 8 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 9 got lock
+(priority-donate-deep) thread 9 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 10 got lock
+(priority-donate-deep) thread 10 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 11 got lock
+(priority-donate-deep) thread 11 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 12 got lock
+(priority-donate-deep) thread 12 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 13 got lock
+(priority-donate-deep) thread 13 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 14 got lock
+(priority-donate-deep) thread 14 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 15 got lock
+(priority-donate-deep) thread 15 should have priority 45. Actual priority: 45
+(priority-donate-deep) thread 15 finishing with priority 45.
+(priority-donate-deep) interloper 15 finished.
+(priority-donate-deep) thread 14 finishing with priority 42.
+(priority-donate-deep) interloper 14 finished.
+(priority-donate-deep) thread 13 finishing with priority 39.
+(priority-donate-deep) interloper 13 finished.
+(priority-donate-deep) thread 12 finishing with priority 36.
+(priority-donate-deep) interloper 12 finished.
+(priority-donate-deep) thread 11 finishing with priority 33.
+(priority-donate-deep) interloper 11 finished.
+(priority-donate-deep) thread 10 finishing with priority 30.
+(priority-donate-deep) interloper 10 finished.
+(priority-donate-deep) thread 9 finishing with priority 27.
+(priority-donate-deep) interloper 9 finished.
+(priority-donate-deep) thread 8 finishing with priority 24.
+(priority-donate-deep) interloper 8 finished.
+(priority-donate-deep) thread 7 finishing with priority 21.
+(priority-donate-deep) interloper 7 finished.
+(priority-donate-deep) thread 6 finishing with priority 18.
+(priority-donate-deep) interloper 6 finished.
+(priority-donate-deep) thread 5 finishing with priority 15.
+(priority-donate-deep) interloper 5 finished.
+(priority-donate-deep) thread 4 finishing with priority 12.
+(priority-donate-deep) interloper 4 finished.
+(priority-donate-deep) thread 3 finishing with priority 9.
+(priority-donate-deep) interloper 3 finished.
+(priority-donate-deep) thread 2 finishing with priority 6.
+(priority-donate-deep) interloper 2 finished.
+(priority-donate-deep) thread 1 finishing with priority 3.
+(priority-donate-deep) interloper 1 finished.
+(priority-donate-deep) main finishing with priority 0.
+(priority-donate-deep) end
+EOF
+pass;
@@ -0,0 +1,64 @@
+/* The main thread acquires a reader-writer lock for reading.
+   Then it creates a reader, which should be able to share the
+   lock, followed by a writer, which has to wait, and two more
+   readers with higher priorities than the writer.  Because a
+   writer is waiting, these readers should have to wait too.
+   When the main thread releases the lock, the writer should get
+   it first, and then both waiting readers, in priority order. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_pref (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  msg ("main: got the lock for reading.");
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  thread_create ("reader 2", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  thread_create ("reader 3", PRI_DEFAULT + 3, reader_thread_func, &rw);
+  msg ("main: releasing the lock.");
+  rwlock_release_read (&rw);
+  msg ("main: done.");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("%s: acquiring the lock for reading.", thread_name ());
+  rwlock_acquire_read (rw);
+  msg ("%s: got the lock for reading.", thread_name ());
+  rwlock_release_read (rw);
+  msg ("%s: done.", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("%s: acquiring the lock for writing.", thread_name ());
+  rwlock_acquire_write (rw);
+  msg ("%s: got the lock for writing.", thread_name ());
+  msg ("%s: releasing the lock.", thread_name ());
+  rwlock_release_write (rw);
+  msg ("%s: done.", thread_name ());
+}
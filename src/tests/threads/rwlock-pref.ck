@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-pref) begin
+(rwlock-pref) main: got the lock for reading.
+(rwlock-pref) reader 1: acquiring the lock for reading.
+(rwlock-pref) reader 1: got the lock for reading.
+(rwlock-pref) reader 1: done.
+(rwlock-pref) writer: acquiring the lock for writing.
+(rwlock-pref) reader 2: acquiring the lock for reading.
+(rwlock-pref) reader 3: acquiring the lock for reading.
+(rwlock-pref) main: releasing the lock.
+(rwlock-pref) writer: got the lock for writing.
+(rwlock-pref) writer: releasing the lock.
+(rwlock-pref) reader 3: got the lock for reading.
+(rwlock-pref) reader 3: done.
+(rwlock-pref) reader 2: got the lock for reading.
+(rwlock-pref) reader 2: done.
+(rwlock-pref) writer: done.
+(rwlock-pref) main: done.
+(rwlock-pref) end
+EOF
+pass;
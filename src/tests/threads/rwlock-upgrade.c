@@ -0,0 +1,86 @@
+/* The main thread and a higher-priority reader both acquire a
+   reader-writer lock for reading, and then the reader tries to
+   upgrade it to writing, which has to wait for the main thread
+   to release the lock.  Meanwhile, an upgrade attempt by the
+   main thread should fail at once, and a writer and a "late"
+   reader, with higher priorities still, should both have to
+   wait.  When the main thread releases the lock, the upgrade
+   should complete before the writer gets the lock, and when the
+   upgraded reader releases it, the late reader should get it
+   before the writer. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func upgrader_thread_func;
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_upgrade (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  msg ("main: got the lock for reading.");
+  thread_create ("reader", PRI_DEFAULT + 1, upgrader_thread_func, &rw);
+  if (rwlock_upgrade (&rw))
+    fail ("main: upgraded while another reader was upgrading.");
+  msg ("main: could not upgrade, as expected.");
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread_func, &rw);
+  thread_create ("late reader", PRI_DEFAULT + 3, reader_thread_func, &rw);
+  msg ("main: releasing the lock.");
+  rwlock_release_read (&rw);
+  msg ("main: done.");
+}
+
+static void
+upgrader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("%s: acquiring the lock for reading.", thread_name ());
+  rwlock_acquire_read (rw);
+  msg ("%s: got the lock for reading.", thread_name ());
+  msg ("%s: upgrading.", thread_name ());
+  if (!rwlock_upgrade (rw))
+    fail ("%s: upgrade failed.", thread_name ());
+  msg ("%s: upgraded to writing.", thread_name ());
+  msg ("%s: releasing the lock.", thread_name ());
+  rwlock_release_write (rw);
+  msg ("%s: done.", thread_name ());
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("%s: acquiring the lock for reading.", thread_name ());
+  rwlock_acquire_read (rw);
+  msg ("%s: got the lock for reading.", thread_name ());
+  rwlock_release_read (rw);
+  msg ("%s: done.", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  msg ("%s: acquiring the lock for writing.", thread_name ());
+  rwlock_acquire_write (rw);
+  msg ("%s: got the lock for writing.", thread_name ());
+  rwlock_release_write (rw);
+  msg ("%s: done.", thread_name ());
+}
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-upgrade) begin
+(rwlock-upgrade) main: got the lock for reading.
+(rwlock-upgrade) reader: acquiring the lock for reading.
+(rwlock-upgrade) reader: got the lock for reading.
+(rwlock-upgrade) reader: upgrading.
+(rwlock-upgrade) main: could not upgrade, as expected.
+(rwlock-upgrade) writer: acquiring the lock for writing.
+(rwlock-upgrade) late reader: acquiring the lock for reading.
+(rwlock-upgrade) main: releasing the lock.
+(rwlock-upgrade) reader: upgraded to writing.
+(rwlock-upgrade) reader: releasing the lock.
+(rwlock-upgrade) late reader: got the lock for reading.
+(rwlock-upgrade) late reader: done.
+(rwlock-upgrade) writer: got the lock for writing.
+(rwlock-upgrade) writer: done.
+(rwlock-upgrade) reader: done.
+(rwlock-upgrade) main: done.
+(rwlock-upgrade) end
+EOF
+pass;
@@ -0,0 +1,99 @@
+/* Checks that a slab cache hands out distinct, aligned objects
+   that stay constructed across frees, and that it keeps one
+   empty slab around instead of giving it back to the page
+   allocator. */
+
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+
+/* Object size and alignment.  The size is deliberately not a
+   multiple of the alignment. */
+#define OBJ_SIZE 100
+#define OBJ_ALIGN 64
+
+/* Number of slabs' worth of objects to allocate. */
+#define SLAB_CNT 3
+
+/* Contents of a constructed object. */
+#define OBJ_PATTERN 0x5a
+
+static struct slab_cache cache;
+static int ctor_cnt;
+
+static void ctor (void *);
+static bool is_constructed (const uint8_t *);
+
+void
+test_slab_cache (void) 
+{
+  static uint8_t *objs[SLAB_CNT * 64];
+  size_t obj_cnt;
+  size_t i, j;
+
+  slab_cache_init (&cache, "test", OBJ_SIZE, OBJ_ALIGN, ctor);
+  ASSERT (SLAB_CNT * cache.objs_per_slab <= sizeof objs / sizeof *objs);
+  obj_cnt = SLAB_CNT * cache.objs_per_slab;
+
+  for (i = 0; i < obj_cnt; i++) 
+    {
+      objs[i] = slab_alloc (&cache);
+      if (objs[i] == NULL)
+        fail ("allocation %zu failed", i);
+      if ((uintptr_t) objs[i] % OBJ_ALIGN != 0)
+        fail ("object %zu misaligned at %p", i, objs[i]);
+      if (!is_constructed (objs[i]))
+        fail ("object %zu not constructed", i);
+      for (j = 0; j < i; j++)
+        if (objs[i] < objs[j] + OBJ_SIZE && objs[j] < objs[i] + OBJ_SIZE)
+          fail ("objects %zu and %zu overlap", j, i);
+      objs[i][0] = 0;
+    }
+  msg ("Allocated %d slabs of objects.", SLAB_CNT);
+  if (ctor_cnt != (int) obj_cnt)
+    fail ("constructor called %d times for %zu objects", ctor_cnt, obj_cnt);
+
+  for (i = 0; i < obj_cnt; i++) 
+    {
+      objs[i][0] = OBJ_PATTERN;
+      slab_free (&cache, objs[i]);
+    }
+  msg ("Freed all objects.");
+  if (cache.slab_cnt != 1)
+    fail ("%zu slabs left, expected 1", cache.slab_cnt);
+
+  for (i = 0; i < cache.objs_per_slab; i++) 
+    {
+      objs[i] = slab_alloc (&cache);
+      if (objs[i] == NULL || !is_constructed (objs[i]))
+        fail ("reallocated object %zu not constructed", i);
+    }
+  if (ctor_cnt != (int) obj_cnt)
+    fail ("objects were constructed again");
+  msg ("Reallocated one slab of objects without constructing them.");
+
+  for (i = 0; i < cache.objs_per_slab; i++)
+    slab_free (&cache, objs[i]);
+}
+
+/* Constructor. */
+static void
+ctor (void *obj) 
+{
+  memset (obj, OBJ_PATTERN, OBJ_SIZE);
+  ctor_cnt++;
+}
+
+/* Returns true if OBJ holds the constructed pattern. */
+static bool
+is_constructed (const uint8_t *obj) 
+{
+  size_t i;
+
+  for (i = 0; i < OBJ_SIZE; i++)
+    if (obj[i] != OBJ_PATTERN)
+      return false;
+  return true;
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) Allocated 3 slabs of objects.
+(slab-cache) Freed all objects.
+(slab-cache) Reallocated one slab of objects without constructing them.
+(slab-cache) end
+EOF
+pass;
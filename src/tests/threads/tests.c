@@ -17,6 +17,8 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-sleepers", test_alarm_sleepers},
+    {"alarm-tickless", test_alarm_tickless},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,10 +27,21 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-deep", test_priority_donate_deep},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"rwlock-pref", test_rwlock_pref},
+    {"rwlock-upgrade", test_rwlock_upgrade},
+    {"lock-stat", test_lock_stat},
+    {"condvar-morph", test_condvar_morph},
+    {"workq-order", test_workq_order},
+    {"slab-cache", test_slab_cache},
+    {"malloc-bench", test_malloc_bench},
+    {"malloc-realloc", test_malloc_realloc},
+    {"heap-stat", test_heap_stat},
+    {"bitmap-bench", test_bitmap_bench},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
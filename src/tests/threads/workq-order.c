@@ -0,0 +1,74 @@
+/* Queues work items at all three work priorities, in mixed
+   order, and checks that the worker threads run them highest
+   priority first, and in the order they were queued within each
+   priority.
+
+   The main thread queues the items at PRI_MAX, so that no worker
+   can run until it is done, and then drops to PRI_MIN, so that
+   the low-priority items cannot run until it waits for them. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workq.h"
+
+static work_func work_func_msg;
+
+/* A work item for this test. */
+struct test_work
+  {
+    struct work work;           /* Work queue item. */
+    const char *name;           /* Name to print. */
+    enum work_priority priority; /* Priority to queue at. */
+    struct semaphore *done;     /* Upped when the item has run. */
+  };
+
+void
+test_workq_order (void) 
+{
+  struct test_work works[] =
+    {
+      {.name = "low 1", .priority = WORK_LOW},
+      {.name = "normal 1", .priority = WORK_NORMAL},
+      {.name = "high 1", .priority = WORK_HIGH},
+      {.name = "high 2", .priority = WORK_HIGH},
+      {.name = "normal 2", .priority = WORK_NORMAL},
+      {.name = "low 2", .priority = WORK_LOW},
+    };
+  const size_t work_cnt = sizeof works / sizeof *works;
+  struct semaphore done;
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  thread_set_priority (PRI_MAX);
+  for (i = 0; i < work_cnt; i++)
+    {
+      struct test_work *w = &works[i];
+      w->done = &done;
+      work_init (&w->work, work_func_msg, w);
+      if (!work_queue (&w->work, w->priority))
+        fail ("couldn't queue %s", w->name);
+    }
+  if (work_queue (&works[0].work, works[0].priority))
+    fail ("queued %s twice", works[0].name);
+  msg ("Queued %zu items.", work_cnt);
+  thread_set_priority (PRI_MIN);
+
+  for (i = 0; i < work_cnt; i++)
+    sema_down (&done);
+  msg ("All items ran.");
+}
+
+static void
+work_func_msg (void *w_) 
+{
+  struct test_work *w = w_;
+
+  msg ("%s", w->name);
+  sema_up (w->done);
+}
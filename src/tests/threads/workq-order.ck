@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workq-order) begin
+(workq-order) Queued 6 items.
+(workq-order) high 1
+(workq-order) high 2
+(workq-order) normal 1
+(workq-order) normal 2
+(workq-order) low 1
+(workq-order) low 2
+(workq-order) All items ran.
+(workq-order) end
+EOF
+pass;
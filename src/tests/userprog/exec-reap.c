@@ -0,0 +1,27 @@
+/* Executes and waits for a long series of child processes, to
+   check that the kernel reclaims everything a child used,
+   including its thread page, once the child has been waited
+   for.  Leaking even a single page per child exhausts the
+   kernel pool long before the loop finishes. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of children to run, one after another. */
+#define CHILD_CNT 20000
+
+void
+test_main (void) 
+{
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      pid_t pid = exec ("child-simple");
+      if (pid == PID_ERROR)
+        fail ("exec of child %d failed", i);
+      if (wait (pid) != 81)
+        fail ("wait for child %d returned wrong status", i);
+    }
+}
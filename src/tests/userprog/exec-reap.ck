@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my ($child_cnt) = 20000;
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my ($line) = shift (@output);
+fail "expected \"(exec-reap) begin\", got \"$line\"\n"
+  unless defined ($line) && $line eq '(exec-reap) begin';
+for my $i (1...$child_cnt) {
+    foreach my $expected ('(child-simple) run', 'child-simple: exit(81)') {
+	$line = shift (@output);
+	fail "child $i: expected \"$expected\", got "
+	  . (defined ($line) ? "\"$line\"" : "end of output") . "\n"
+	  unless defined ($line) && $line eq $expected;
+    }
+}
+foreach my $expected ('(exec-reap) end', 'exec-reap: exit(0)') {
+    $line = shift (@output);
+    fail "expected \"$expected\", got "
+      . (defined ($line) ? "\"$line\"" : "end of output") . "\n"
+      unless defined ($line) && $line eq $expected;
+}
+pass;
@@ -0,0 +1,89 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* Signed 17.14 fixed-point arithmetic, for the multi-level
+   feedback queue scheduler, which needs fractional values for
+   load_avg and recent_cpu but runs in a kernel that does not
+   support floating point.
+
+   A fixed-point number X represents the real number
+   X / FP_ONE.  The 17 bits to the left of the binary point hold
+   values up to 131,071, which is plenty for both quantities. */
+typedef int32_t fixed_point_t;
+
+#define FP_SHIFT 14                     /* Fraction bits. */
+#define FP_ONE (1 << FP_SHIFT)          /* 1.0 in fixed point. */
+
+/* Converts integer N to fixed point. */
+static inline fixed_point_t
+fp_from_int (int n)
+{
+  return n * FP_ONE;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int
+fp_to_int (fixed_point_t x)
+{
+  return x / FP_ONE;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int
+fp_round (fixed_point_t x)
+{
+  return x >= 0 ? (x + FP_ONE / 2) / FP_ONE : (x - FP_ONE / 2) / FP_ONE;
+}
+
+/* Returns X + Y. */
+static inline fixed_point_t
+fp_add (fixed_point_t x, fixed_point_t y)
+{
+  return x + y;
+}
+
+/* Returns X + N, where N is an integer. */
+static inline fixed_point_t
+fp_add_int (fixed_point_t x, int n)
+{
+  return x + n * FP_ONE;
+}
+
+/* Returns X - Y. */
+static inline fixed_point_t
+fp_sub (fixed_point_t x, fixed_point_t y)
+{
+  return x - y;
+}
+
+/* Returns X * Y. */
+static inline fixed_point_t
+fp_mul (fixed_point_t x, fixed_point_t y)
+{
+  return ((int64_t) x) * y / FP_ONE;
+}
+
+/* Returns X * N, where N is an integer. */
+static inline fixed_point_t
+fp_mul_int (fixed_point_t x, int n)
+{
+  return x * n;
+}
+
+/* Returns X / Y. */
+static inline fixed_point_t
+fp_div (fixed_point_t x, fixed_point_t y)
+{
+  return ((int64_t) x) * FP_ONE / y;
+}
+
+/* Returns X / N, where N is an integer. */
+static inline fixed_point_t
+fp_div_int (fixed_point_t x, int n)
+{
+  return x / n;
+}
+
+#endif /* threads/fixed-point.h */
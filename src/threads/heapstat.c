@@ -0,0 +1,352 @@
+#include "threads/heapstat.h"
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Kernel heap usage tracking.
+
+   When the kernel is run with "-heapstat", malloc() and the page
+   allocator report each allocation and free here.  Each live
+   allocation is recorded in a hash table, along with the call
+   site that made it, that is, the return address of the call to
+   malloc(), palloc_get_page(), and so on.  Totals are kept per
+   call site and per class of allocation.  At shutdown, the call
+   sites holding the most memory are printed, which is usually
+   enough to find a leak.  The `backtrace' program turns the
+   addresses into function names and line numbers.
+
+   The pages that malloc() carves into blocks are allocations of
+   their pool's class too, but they are left out of the overall
+   totals, which would otherwise count the same memory once as
+   pages and again as blocks.
+
+   Both tables have fixed sizes.  Allocations that do not fit
+   are not tracked, but they are counted, so that the report
+   can say how incomplete it is.  All of the tracking data is
+   protected by turning off interrupts. */
+
+/* Number of slots in the live allocation table.  Must be a power
+   of 2. */
+#define LIVE_SLOTS 4096
+
+/* Maximum number of live allocations tracked at once.  Keeping
+   the table partly empty keeps its probe sequences short. */
+#define LIVE_MAX (LIVE_SLOTS * 3 / 4)
+
+/* Number of slots in the call site table.  Must be a power of
+   2. */
+#define SITE_SLOTS 256
+
+/* Number of call sites in the shutdown report. */
+#define TOP_SITES 10
+
+/* A call site. */
+struct site
+  {
+    const void *caller;         /* Return address; null if unused. */
+    size_t live_cnt;            /* Number of live allocations. */
+    size_t live_bytes;          /* Bytes in live allocations. */
+    long long alloc_cnt;        /* Number of allocations. */
+  };
+
+/* A live allocation. */
+struct live
+  {
+    const void *ptr;            /* Allocated block; null if unused. */
+    struct heap_class *class;   /* Class of allocation. */
+    struct site *site;          /* Call site. */
+    size_t bytes;               /* Size in bytes. */
+    bool in_total;              /* Counted in the overall totals? */
+  };
+
+/* If true, track kernel heap usage.  Set by the kernel
+   command-line option "-heapstat". */
+bool heapstat;
+
+/* All heap classes. */
+static struct list classes = LIST_INITIALIZER (classes);
+
+/* Call sites and live allocations.  LIVE_TABLE is null until
+   heapstat_init() has been called. */
+static struct site sites[SITE_SLOTS];
+static struct live *live_table;
+static size_t live_cnt;
+
+/* Overall totals. */
+static size_t total_cnt;                /* Live allocations counted. */
+static size_t live_bytes;               /* Bytes currently allocated. */
+static size_t peak_bytes;               /* Maximum of LIVE_BYTES. */
+static long long untracked_cnt;         /* Allocations not tracked. */
+
+static size_t live_home (const void *, const struct heap_class *);
+static struct live *find_live (const void *, const struct heap_class *);
+static void delete_live (struct live *);
+static struct site *find_site (const void *caller);
+static void adjust (struct live *, size_t bytes);
+
+/* Starts tracking kernel heap usage, if "-heapstat" was given.
+   Must be called after the page allocator is initialized.
+   Allocations made earlier are not tracked. */
+void
+heapstat_init (void) 
+{
+  if (heapstat)
+    live_table = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+                                      DIV_ROUND_UP (LIVE_SLOTS
+                                                    * sizeof *live_table,
+                                                    PGSIZE));
+}
+
+/* Initializes heap class C, naming it NAME for statistics. */
+void
+heapstat_class_init (struct heap_class *c, const char *name) 
+{
+  enum intr_level old_level;
+
+  c->name = name;
+  c->live_bytes = c->peak_bytes = 0;
+  c->alloc_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&classes, &c->elem);
+  intr_set_level (old_level);
+}
+
+/* Records that PTR, of class C, has been allocated with size
+   BYTES by the call that returns to CALLER.  The allocation is
+   counted in the overall totals only if IN_TOTAL is true. */
+void
+heapstat_alloc (struct heap_class *c, const void *ptr, size_t bytes,
+                const void *caller, bool in_total) 
+{
+  enum intr_level old_level;
+  struct site *site;
+  struct live *l;
+
+  if (live_table == NULL || ptr == NULL)
+    return;
+
+  old_level = intr_disable ();
+  site = find_site (caller);
+  if (site == NULL || live_cnt >= LIVE_MAX)
+    untracked_cnt++;
+  else
+    {
+      l = find_live (ptr, c);
+      ASSERT (l->ptr == NULL);
+      l->ptr = ptr;
+      l->class = c;
+      l->site = site;
+      l->bytes = 0;
+      l->in_total = in_total;
+      live_cnt++;
+      if (in_total)
+        total_cnt++;
+      site->live_cnt++;
+      site->alloc_cnt++;
+      c->alloc_cnt++;
+      adjust (l, bytes);
+    }
+  intr_set_level (old_level);
+}
+
+/* Records that PTR, of class C, has been resized in place to
+   BYTES bytes. */
+void
+heapstat_resize (struct heap_class *c, const void *ptr, size_t bytes) 
+{
+  enum intr_level old_level;
+  struct live *l;
+
+  if (live_table == NULL || ptr == NULL)
+    return;
+
+  old_level = intr_disable ();
+  l = find_live (ptr, c);
+  if (l->ptr != NULL)
+    adjust (l, bytes);
+  intr_set_level (old_level);
+}
+
+/* Records that PTR, of class C, has been freed. */
+void
+heapstat_free (struct heap_class *c, const void *ptr) 
+{
+  enum intr_level old_level;
+  struct live *l;
+
+  if (live_table == NULL || ptr == NULL)
+    return;
+
+  old_level = intr_disable ();
+  l = find_live (ptr, c);
+  if (l->ptr != NULL) 
+    {
+      adjust (l, 0);
+      l->site->live_cnt--;
+      live_cnt--;
+      if (l->in_total)
+        total_cnt--;
+      delete_live (l);
+    }
+  intr_set_level (old_level);
+}
+
+/* Prints heap usage by class and the call sites with the most
+   memory allocated, if "-heapstat" was given. */
+void
+heapstat_print_stats (void) 
+{
+  bool printed[SITE_SLOTS];
+  struct list_elem *e;
+  int i;
+
+  if (live_table == NULL)
+    return;
+
+  printf ("Heap: %zu bytes in %zu live allocations, peak %zu bytes, "
+          "%lld not tracked\n",
+          live_bytes, total_cnt, peak_bytes, untracked_cnt);
+  for (e = list_begin (&classes); e != list_end (&classes);
+       e = list_next (e)) 
+    {
+      struct heap_class *c = list_entry (e, struct heap_class, elem);
+      if (c->alloc_cnt > 0)
+        printf ("Heap: %s: %zu bytes live, peak %zu bytes, "
+                "%lld allocations\n",
+                c->name, c->live_bytes, c->peak_bytes, c->alloc_cnt);
+    }
+
+  /* Print the top call sites by live bytes, largest first. */
+  for (i = 0; i < SITE_SLOTS; i++)
+    printed[i] = false;
+  for (i = 0; i < TOP_SITES; i++) 
+    {
+      struct site *top = NULL;
+      int j;
+
+      for (j = 0; j < SITE_SLOTS; j++)
+        if (!printed[j] && sites[j].live_cnt > 0
+            && (top == NULL || sites[j].live_bytes > top->live_bytes))
+          top = &sites[j];
+      if (top == NULL)
+        break;
+      printed[top - sites] = true;
+      printf ("Heap: %#010"PRIxPTR": %zu bytes in %zu live allocations, "
+              "%lld total\n",
+              (uintptr_t) top->caller, top->live_bytes, top->live_cnt,
+              top->alloc_cnt);
+    }
+}
+
+/* Sets the size of live allocation L to BYTES, updating the
+   totals.  Interrupts must be off. */
+static void
+adjust (struct live *l, size_t bytes) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  l->class->live_bytes = l->class->live_bytes - l->bytes + bytes;
+  l->site->live_bytes = l->site->live_bytes - l->bytes + bytes;
+  if (l->in_total) 
+    {
+      live_bytes = live_bytes - l->bytes + bytes;
+      if (live_bytes > peak_bytes)
+        peak_bytes = live_bytes;
+    }
+  l->bytes = bytes;
+
+  if (l->class->live_bytes > l->class->peak_bytes)
+    l->class->peak_bytes = l->class->live_bytes;
+}
+
+/* Returns the slot where the live allocation of PTR in class C
+   would ideally be. */
+static size_t
+live_home (const void *ptr, const struct heap_class *c) 
+{
+  uintptr_t key = (uintptr_t) ptr ^ (uintptr_t) c;
+  return hash_bytes (&key, sizeof key) & (LIVE_SLOTS - 1);
+}
+
+/* Returns the live allocation of PTR in class C, or the empty
+   slot where it belongs if there is none.  Interrupts must be
+   off. */
+static struct live *
+find_live (const void *ptr, const struct heap_class *c) 
+{
+  size_t i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (i = live_home (ptr, c); ; i = (i + 1) & (LIVE_SLOTS - 1)) 
+    {
+      struct live *l = &live_table[i];
+      if (l->ptr == NULL || (l->ptr == ptr && l->class == c))
+        return l;
+    }
+}
+
+/* Empties slot L of the live allocation table, moving later
+   entries back so that every entry stays reachable from its
+   home slot.  Interrupts must be off. */
+static void
+delete_live (struct live *l) 
+{
+  size_t hole = l - live_table;
+  size_t i = hole;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (;;) 
+    {
+      size_t home;
+
+      i = (i + 1) & (LIVE_SLOTS - 1);
+      if (live_table[i].ptr == NULL)
+        break;
+
+      /* An entry may fill the hole only if its home slot does
+         not lie cyclically within (HOLE, I]. */
+      home = live_home (live_table[i].ptr, live_table[i].class);
+      if (hole < i ? hole < home && home <= i : hole < home || home <= i)
+        continue;
+      live_table[hole] = live_table[i];
+      hole = i;
+    }
+  live_table[hole].ptr = NULL;
+}
+
+/* Returns the call site for CALLER, creating it if necessary,
+   or a null pointer if the table is full.  Interrupts must be
+   off. */
+static struct site *
+find_site (const void *caller) 
+{
+  uintptr_t key = (uintptr_t) caller;
+  size_t home = hash_bytes (&key, sizeof key) & (SITE_SLOTS - 1);
+  size_t i = home;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  do 
+    {
+      struct site *s = &sites[i];
+      if (s->caller == caller)
+        return s;
+      else if (s->caller == NULL) 
+        {
+          s->caller = caller;
+          return s;
+        }
+      i = (i + 1) & (SITE_SLOTS - 1);
+    }
+  while (i != home);
+  return NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef THREADS_HEAPSTAT_H
+#define THREADS_HEAPSTAT_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A class of allocations whose usage is totaled together, such
+   as the blocks of one malloc() size class or the pages of one
+   pool.  Totals are only kept if the kernel is run with
+   "-heapstat". */
+struct heap_class
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t live_bytes;          /* Bytes currently allocated. */
+    size_t peak_bytes;          /* Maximum of LIVE_BYTES. */
+    long long alloc_cnt;        /* Number of allocations. */
+    struct list_elem elem;      /* Element in list of all classes. */
+  };
+
+/* If true, track kernel heap usage. */
+extern bool heapstat;
+
+void heapstat_init (void);
+void heapstat_class_init (struct heap_class *, const char *name);
+void heapstat_alloc (struct heap_class *, const void *, size_t bytes,
+                     const void *caller, bool in_total);
+void heapstat_resize (struct heap_class *, const void *, size_t bytes);
+void heapstat_free (struct heap_class *, const void *);
+void heapstat_print_stats (void);
+
+#endif /* threads/heapstat.h */
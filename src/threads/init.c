@@ -15,13 +15,16 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/heapstat.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workq.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -37,6 +40,11 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -97,7 +105,12 @@ main (void)
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
+  heapstat_init ();
   paging_init ();
+#ifdef VM
+  page_init ();
+  frame_init ();
+#endif
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -117,6 +130,7 @@ main (void)
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  workq_init ();
   serial_init_queue ();
   timer_calibrate ();
 
@@ -127,6 +141,11 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize swap. */
+  swap_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -251,11 +270,37 @@ parse_options (char **argv)
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
 #endif
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-stack"))
+        {
+          int kb = value != NULL ? atoi (value) : 0;
+          if (kb <= 0 || kb % (PGSIZE / 1024) != 0)
+            PANIC ("-stack requires a positive multiple of %d kB",
+                   PGSIZE / 1024);
+          stack_limit = (size_t) kb * 1024;
+        }
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-lockstat"))
+        lockstat = true;
+      else if (!strcmp (name, "-heapstat"))
+        heapstat = true;
+      else if (!strcmp (name, "-pcache"))
+        {
+          char *comma = value != NULL ? strchr (value, ',') : NULL;
+          int low = comma != NULL ? atoi (value) : -1;
+          int high = comma != NULL ? atoi (comma + 1) : -1;
+          if (low < 0 || high <= low || high > PALLOC_CACHE_MAX)
+            PANIC ("-pcache requires 0 <= LOW < HIGH <= %d",
+                   PALLOC_CACHE_MAX);
+          palloc_set_cache_watermarks (low, high);
+        }
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -376,9 +421,16 @@ usage (void)
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
+#endif
+#ifdef VM
+          "  -stack=KB          Limit user stacks to KB kB (default 8192).\n"
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -tickless          Stop periodic timer ticks while idle.\n"
+          "  -lockstat          Print lock contention statistics at shutdown.\n"
+          "  -heapstat          Print kernel heap usage at shutdown.\n"
+          "  -pcache=LOW,HIGH   Set page cache low and high watermarks.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -1,21 +1,29 @@
 #include "threads/malloc.h"
+#include <bitmap.h>
 #include <debug.h>
 #include <list.h>
 #include <round.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/heapstat.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  Size classes go up in 16-byte
+   steps to 128 bytes, then in steps of a quarter of the next
+   lower power of 2: 160, 192, 224, 256, 320, and so on.  So no
+   more than about 20% of a block is wasted, instead of up to
+   half with power-of-2 sizes.  The descriptor keeps a list of
+   free blocks.  If the free list is nonempty, one of its blocks
+   is used to satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -28,11 +36,39 @@
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   Each descriptor's free list is protected by a lock.  Most
+   calls never take it, though, because each descriptor also
+   keeps a small "magazine" of free blocks, accessed with
+   interrupts off, in front of the free list.  malloc() takes a
+   block from the magazine if it can, and otherwise loads the
+   magazine half full from the free list while it has the lock.
+   free() puts the block into the magazine if there is room, and
+   otherwise returns half of the magazine to the free list.
+   Blocks in a magazine count as in use in their arenas.
+
+   We can't handle blocks bigger than about 2 kB using this
+   scheme, because too few of them fit in a single page with a
+   descriptor.  Blocks up to 16 kB are "mid-size": they are
+   carved, in 256-byte units, out of 64 kB "runs" of contiguous
+   pages.  Each run's bookkeeping is kept in a separate run
+   structure, not in the run itself, so that a 4 kB block takes
+   exactly 4 kB.  A map from each page of RAM to the run that
+   contains it, if any, lets free() tell mid-size blocks apart
+   from the others.
+
+   We handle bigger blocks by allocating contiguous pages with
+   the page allocator and sticking the allocation size at the
+   beginning of the allocated block's arena header.
+
+   realloc() resizes a block in place when it can: within its
+   size class for normal blocks, or by taking or giving back the
+   units or pages that follow it for mid-size and big blocks. */
+
+/* Number of free blocks a descriptor's magazine can hold. */
+#define MAGAZINE_SIZE 16
+
+/* Largest size class in 16-byte steps. */
+#define SMALL_CLASS_MAX 128
 
 /* Descriptor. */
 struct desc
@@ -41,6 +77,12 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    char name[16];              /* Lock name, for statistics. */
+    struct heap_class heap;     /* Usage, for "-heapstat". */
+
+    /* Accessed with interrupts off. */
+    struct block *magazine[MAGAZINE_SIZE]; /* Free blocks. */
+    size_t magazine_cnt;        /* Number of blocks in MAGAZINE. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -61,9 +103,44 @@ struct block
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[32];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Mid-size blocks. */
+#define MID_UNIT 256            /* Allocation unit, in bytes. */
+#define MID_MAX (16 * 1024)     /* Largest mid-size block. */
+#define RUN_PAGES 16            /* Pages in a run. */
+#define RUN_UNITS (RUN_PAGES * PGSIZE / MID_UNIT) /* Units in a run. */
+
+/* A run of pages divided into mid-size blocks. */
+struct run
+  {
+    uint8_t *base;              /* First page of run. */
+    struct list_elem elem;      /* Element in run_list. */
+    size_t free_units;          /* Number of free units. */
+    struct bitmap *used_map;    /* Bitmap of used units. */
+    uint8_t unit_cnt[RUN_UNITS]; /* Units in block at each unit, or 0. */
+  };
+
+static struct list run_list;    /* All runs. */
+static size_t empty_run_cnt;    /* Number of runs with no blocks. */
+static struct lock run_lock;    /* Protects runs and the above. */
+static struct run **run_map;    /* Run containing each page of RAM. */
+
+/* Usage of mid-size and big blocks, for "-heapstat". */
+static struct heap_class mid_heap, big_heap;
+
+static void init_desc (size_t block_size);
+static struct desc *size_to_desc (size_t size);
+static void free_block (struct desc *, struct block *);
+static struct run *page_to_run (const void *);
+static void *mid_alloc (size_t size);
+static void mid_free (struct run *, void *);
+static bool resize_in_place (void *, size_t new_size);
+static void *alloc_block (size_t size);
+static size_t block_size (void *);
+static struct heap_class *block_class (void *);
+static void track_block (void *, const void *caller);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
@@ -71,24 +148,84 @@ static struct block *arena_to_block (struct arena *, size_t idx);
 void
 malloc_init (void) 
 {
-  size_t block_size;
-
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+  size_t block_size, step;
+
+  list_init (&run_list);
+  lock_init_named (&run_lock, "malloc runs");
+  heapstat_class_init (&mid_heap, "malloc mid-size");
+  heapstat_class_init (&big_heap, "malloc big");
+  run_map = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+                                 DIV_ROUND_UP (init_ram_pages * sizeof *run_map,
+                                               PGSIZE));
+
+  for (block_size = 16; block_size <= SMALL_CLASS_MAX; block_size += 16)
+    init_desc (block_size);
+
+  /* Add quarter-power-of-2 steps for as long as an arena holds
+     at least two blocks. */
+  for (step = SMALL_CLASS_MAX / 4; ; step *= 2) 
     {
-      struct desc *d = &descs[desc_cnt++];
-      ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-      d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
-      lock_init (&d->lock);
+      int i;
+
+      for (i = 0; i < 4; i++) 
+        {
+          block_size += step;
+          if ((PGSIZE - sizeof (struct arena)) / block_size < 2)
+            return;
+          init_desc (block_size);
+        }
     }
 }
 
+/* Initializes a descriptor for BLOCK_SIZE-byte blocks. */
+static void
+init_desc (size_t block_size) 
+{
+  struct desc *d = &descs[desc_cnt++];
+
+  ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+  d->block_size = block_size;
+  d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+  list_init (&d->free_list);
+  snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+  lock_init_named (&d->lock, d->name);
+  heapstat_class_init (&d->heap, d->name);
+  d->magazine_cnt = 0;
+}
+
+/* Returns the descriptor with the smallest blocks that hold
+   SIZE bytes, or a null pointer if SIZE is too big for any
+   descriptor.  SIZE must be nonzero. */
+static struct desc *
+size_to_desc (size_t size) 
+{
+  struct desc *d;
+
+  ASSERT (size > 0);
+  if (size <= SMALL_CLASS_MAX)
+    return &descs[(size - 1) / 16];
+  for (d = descs + SMALL_CLASS_MAX / 16; d < descs + desc_cnt; d++)
+    if (d->block_size >= size)
+      return d;
+  return NULL;
+}
+
 /* Obtains and returns a new block of at least SIZE bytes.
    Returns a null pointer if memory is not available. */
 void *
 malloc (size_t size) 
 {
+  void *p = alloc_block (size);
+  track_block (p, __builtin_return_address (0));
+  return p;
+}
+
+/* Implements malloc(), without recording the allocation for
+   "-heapstat". */
+static void *
+alloc_block (size_t size) 
+{
+  enum intr_level old_level;
   struct desc *d;
   struct block *b;
   struct arena *a;
@@ -99,15 +236,24 @@ malloc (size_t size)
 
   /* Find the smallest descriptor that satisfies a SIZE-byte
      request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  d = size_to_desc (size);
+  if (d == NULL) 
     {
-      /* SIZE is too big for any descriptor.
-         Allocate enough pages to hold SIZE plus an arena. */
-      size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-      a = palloc_get_multiple (0, page_cnt);
+      size_t page_cnt;
+
+      /* SIZE is too big for any descriptor.  Try to carve it
+         out of a run, unless it's too big for that too or no
+         run can be had. */
+      if (size <= MID_MAX) 
+        {
+          void *p = mid_alloc (size);
+          if (p != NULL)
+            return p;
+        }
+
+      /* Allocate enough pages to hold SIZE plus an arena. */
+      page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
+      a = palloc_get_multiple (PAL_BACKING, page_cnt);
       if (a == NULL)
         return NULL;
 
@@ -119,6 +265,16 @@ malloc (size_t size)
       return a + 1;
     }
 
+  /* Take a block from the magazine, if it has any. */
+  old_level = intr_disable ();
+  if (d->magazine_cnt > 0) 
+    {
+      b = d->magazine[--d->magazine_cnt];
+      intr_set_level (old_level);
+      return b;
+    }
+  intr_set_level (old_level);
+
   lock_acquire (&d->lock);
 
   /* If the free list is empty, create a new arena. */
@@ -127,7 +283,7 @@ malloc (size_t size)
       size_t i;
 
       /* Allocate a page. */
-      a = palloc_get_page (0);
+      a = palloc_get_page (PAL_BACKING);
       if (a == NULL) 
         {
           lock_release (&d->lock);
@@ -145,10 +301,19 @@ malloc (size_t size)
         }
     }
 
-  /* Get a block from free list and return it. */
+  /* Get a block from free list, and load the magazine from it
+     while we have the lock. */
   b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
+  block_to_arena (b)->free_cnt--;
+  old_level = intr_disable ();
+  while (d->magazine_cnt < MAGAZINE_SIZE / 2 && !list_empty (&d->free_list)) 
+    {
+      struct block *m = list_entry (list_pop_front (&d->free_list),
+                                    struct block, free_elem);
+      block_to_arena (m)->free_cnt--;
+      d->magazine[d->magazine_cnt++] = m;
+    }
+  intr_set_level (old_level);
   lock_release (&d->lock);
   return b;
 }
@@ -167,7 +332,8 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = alloc_block (size);
+  track_block (p, __builtin_return_address (0));
   if (p != NULL)
     memset (p, 0, size);
 
@@ -178,10 +344,15 @@ calloc (size_t a, size_t b)
 static size_t
 block_size (void *block) 
 {
-  struct block *b = block;
-  struct arena *a = block_to_arena (b);
-  struct desc *d = a->desc;
+  struct run *r = page_to_run (block);
+  struct arena *a;
+  struct desc *d;
+
+  if (r != NULL)
+    return r->unit_cnt[((uint8_t *) block - r->base) / MID_UNIT] * MID_UNIT;
 
+  a = block_to_arena (block);
+  d = a->desc;
   return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
 }
 
@@ -199,9 +370,17 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    {
+      if (heapstat)
+        heapstat_resize (block_class (old_block), old_block,
+                         block_size (old_block));
+      return old_block;
+    }
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = alloc_block (new_size);
+      track_block (new_block, __builtin_return_address (0));
       if (old_block != NULL && new_block != NULL)
         {
           size_t old_size = block_size (old_block);
@@ -218,7 +397,15 @@ realloc (void *old_block, size_t new_size)
 void
 free (void *p) 
 {
-  if (p != NULL)
+  if (p != NULL && heapstat)
+    heapstat_free (block_class (p), p);
+
+  if (p != NULL && page_to_run (p) != NULL)
+    {
+      /* It's a mid-size block. */
+      mid_free (page_to_run (p), p);
+    }
+  else if (p != NULL)
     {
       struct block *b = p;
       struct arena *a = block_to_arena (b);
@@ -227,31 +414,40 @@ free (void *p)
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          struct block *flush[MAGAZINE_SIZE / 2];
+          enum intr_level old_level;
+          size_t flush_cnt, i;
 
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          /* Put the block in the magazine, if there's room. */
+          old_level = intr_disable ();
+#ifndef NDEBUG
+          for (i = 0; i < d->magazine_cnt; i++)
+            ASSERT (d->magazine[i] != b);
+#endif
+          if (d->magazine_cnt < MAGAZINE_SIZE) 
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              d->magazine[d->magazine_cnt++] = b;
+              intr_set_level (old_level);
+              return;
             }
+          intr_set_level (old_level);
 
+          /* The magazine is full.  Return half of it, along with
+             the block, to the free list. */
+          lock_acquire (&d->lock);
+          old_level = intr_disable ();
+          for (flush_cnt = 0; flush_cnt < MAGAZINE_SIZE / 2
+                 && d->magazine_cnt > MAGAZINE_SIZE / 2; flush_cnt++)
+            flush[flush_cnt] = d->magazine[--d->magazine_cnt];
+          intr_set_level (old_level);
+          for (i = 0; i < flush_cnt; i++)
+            free_block (d, flush[i]);
+          free_block (d, b);
           lock_release (&d->lock);
         }
       else
@@ -263,6 +459,272 @@ free (void *p)
     }
 }
 
+/* Adds block B to descriptor D's free list, freeing its arena
+   if that leaves the arena entirely unused.  D's lock must be
+   held. */
+static void
+free_block (struct desc *d, struct block *b) 
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+
+  /* If the arena is now entirely unused, free it. */
+  if (++a->free_cnt >= d->blocks_per_arena) 
+    {
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      palloc_free_page (a);
+    }
+}
+
+/* Returns the "-heapstat" class of BLOCK. */
+static struct heap_class *
+block_class (void *block) 
+{
+  struct arena *a;
+
+  if (page_to_run (block) != NULL)
+    return &mid_heap;
+  a = block_to_arena (block);
+  return a->desc != NULL ? &a->desc->heap : &big_heap;
+}
+
+/* Records BLOCK, if nonnull, as allocated by CALLER for
+   "-heapstat". */
+static void
+track_block (void *block, const void *caller) 
+{
+  if (heapstat && block != NULL)
+    heapstat_alloc (block_class (block), block, block_size (block), caller,
+                    true);
+}
+
+/* Returns the run that contains P, or a null pointer if P is
+   not in a run. */
+static struct run *
+page_to_run (const void *p) 
+{
+  return run_map[vtop (p) >> PGBITS];
+}
+
+/* Creates and returns a new, empty run, or a null pointer if
+   memory is not available.  run_lock must be held. */
+static struct run *
+new_run (void) 
+{
+  struct run *r;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&run_lock));
+
+  r = malloc (sizeof *r);
+  if (r == NULL)
+    return NULL;
+  r->base = palloc_get_multiple (PAL_BACKING, RUN_PAGES);
+  r->used_map = bitmap_create (RUN_UNITS);
+  if (r->base == NULL || r->used_map == NULL) 
+    {
+      palloc_free_multiple (r->base, RUN_PAGES);
+      bitmap_destroy (r->used_map);
+      free (r);
+      return NULL;
+    }
+  r->free_units = RUN_UNITS;
+  memset (r->unit_cnt, 0, sizeof r->unit_cnt);
+
+  for (i = 0; i < RUN_PAGES; i++)
+    run_map[(vtop (r->base) >> PGBITS) + i] = r;
+  list_push_front (&run_list, &r->elem);
+  empty_run_cnt++;
+  return r;
+}
+
+/* Destroys run R, which must be empty.  run_lock must be
+   held. */
+static void
+destroy_run (struct run *r) 
+{
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&run_lock));
+  ASSERT (r->free_units == RUN_UNITS);
+
+  for (i = 0; i < RUN_PAGES; i++)
+    run_map[(vtop (r->base) >> PGBITS) + i] = NULL;
+  list_remove (&r->elem);
+  palloc_free_multiple (r->base, RUN_PAGES);
+  bitmap_destroy (r->used_map);
+  free (r);
+}
+
+/* Allocates and returns a mid-size block of at least SIZE
+   bytes, or a null pointer if no run has room and no new run
+   can be created. */
+static void *
+mid_alloc (size_t size) 
+{
+  size_t unit_cnt = DIV_ROUND_UP (size, MID_UNIT);
+  size_t unit_idx = BITMAP_ERROR;
+  struct list_elem *e;
+  struct run *r = NULL;
+
+  ASSERT (size <= MID_MAX);
+
+  lock_acquire (&run_lock);
+  for (e = list_begin (&run_list); e != list_end (&run_list);
+       e = list_next (e)) 
+    {
+      r = list_entry (e, struct run, elem);
+      if (r->free_units >= unit_cnt) 
+        {
+          unit_idx = bitmap_scan_and_flip (r->used_map, 0, unit_cnt, false);
+          if (unit_idx != BITMAP_ERROR)
+            break;
+        }
+    }
+  if (unit_idx == BITMAP_ERROR) 
+    {
+      r = new_run ();
+      if (r == NULL) 
+        {
+          lock_release (&run_lock);
+          return NULL;
+        }
+      unit_idx = bitmap_scan_and_flip (r->used_map, 0, unit_cnt, false);
+    }
+
+  if (r->free_units == RUN_UNITS)
+    empty_run_cnt--;
+  r->free_units -= unit_cnt;
+  r->unit_cnt[unit_idx] = unit_cnt;
+  lock_release (&run_lock);
+
+  return r->base + unit_idx * MID_UNIT;
+}
+
+/* Frees P, a mid-size block in run R.  Keeps one empty run
+   around, so that allocating and freeing a single block over
+   and over doesn't create and destroy a run each time. */
+static void
+mid_free (struct run *r, void *p) 
+{
+  size_t ofs = (uint8_t *) p - r->base;
+  size_t unit_idx = ofs / MID_UNIT;
+  size_t unit_cnt;
+
+  ASSERT (ofs % MID_UNIT == 0);
+
+  lock_acquire (&run_lock);
+  unit_cnt = r->unit_cnt[unit_idx];
+  ASSERT (unit_cnt > 0);
+  ASSERT (bitmap_all (r->used_map, unit_idx, unit_cnt));
+
+#ifndef NDEBUG
+  /* Clear the block to help detect use-after-free bugs. */
+  memset (p, 0xcc, unit_cnt * MID_UNIT);
+#endif
+
+  bitmap_set_multiple (r->used_map, unit_idx, unit_cnt, false);
+  r->unit_cnt[unit_idx] = 0;
+  r->free_units += unit_cnt;
+  if (r->free_units == RUN_UNITS) 
+    {
+      if (empty_run_cnt > 0)
+        destroy_run (r);
+      else
+        empty_run_cnt++;
+    }
+  lock_release (&run_lock);
+}
+
+/* Tries to resize P, a mid-size block in run R, to NEW_SIZE
+   bytes without moving it, by giving back the units at its end
+   or taking the free units that follow it.  Returns true if
+   successful. */
+static bool
+mid_resize (struct run *r, void *p, size_t new_size) 
+{
+  size_t unit_idx = ((uint8_t *) p - r->base) / MID_UNIT;
+  size_t new_cnt = DIV_ROUND_UP (new_size, MID_UNIT);
+  size_t old_cnt;
+  bool success = true;
+
+  /* A block that no longer belongs in a run has to move. */
+  if (new_size > MID_MAX || size_to_desc (new_size) != NULL)
+    return false;
+
+  lock_acquire (&run_lock);
+  old_cnt = r->unit_cnt[unit_idx];
+  if (new_cnt < old_cnt)
+    bitmap_set_multiple (r->used_map, unit_idx + new_cnt, old_cnt - new_cnt,
+                         false);
+  else if (new_cnt > old_cnt) 
+    {
+      if (unit_idx + new_cnt <= RUN_UNITS
+          && bitmap_none (r->used_map, unit_idx + old_cnt, new_cnt - old_cnt))
+        bitmap_set_multiple (r->used_map, unit_idx + old_cnt,
+                             new_cnt - old_cnt, true);
+      else
+        success = false;
+    }
+  if (success) 
+    {
+      r->free_units = r->free_units + old_cnt - new_cnt;
+      r->unit_cnt[unit_idx] = new_cnt;
+    }
+  lock_release (&run_lock);
+
+  return success;
+}
+
+/* Tries to resize big block A to NEW_SIZE bytes without moving
+   it, by giving back the pages at its end or taking the free
+   pages that follow it.  Returns true if successful. */
+static bool
+big_resize (struct arena *a, size_t new_size) 
+{
+  size_t new_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+
+  /* A block that is no longer big has to move. */
+  if (new_size <= MID_MAX)
+    return false;
+
+  if (new_cnt < a->free_cnt)
+    palloc_shrink (a, a->free_cnt, new_cnt);
+  else if (new_cnt > a->free_cnt && !palloc_extend (a, a->free_cnt, new_cnt))
+    return false;
+  a->free_cnt = new_cnt;
+  return true;
+}
+
+/* Tries to resize BLOCK to NEW_SIZE bytes without moving it.
+   Returns true if successful. */
+static bool
+resize_in_place (void *block, size_t new_size) 
+{
+  struct run *r = page_to_run (block);
+  struct arena *a;
+
+  if (r != NULL)
+    return mid_resize (r, block, new_size);
+
+  a = block_to_arena (block);
+  if (a->desc != NULL)
+    return size_to_desc (new_size) == a->desc;
+  else
+    return big_resize (a, new_size);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -7,9 +7,12 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/heapstat.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/workq.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -23,14 +26,84 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, pages are managed by a binary buddy allocator.
+   Free memory is kept as blocks of 2**K pages, for "orders" K
+   from 0 to BUDDY_ORDERS - 1, each aligned on a multiple of its
+   size relative to the base of the pool, on one free list per
+   order.  A request for N pages takes a block of the smallest
+   order that fits, splitting a larger block if necessary, and
+   returns the pages beyond N to the free lists.  A freed block
+   is merged with its "buddy", the other half of the block of the
+   next larger order, for as long as the buddy is free too.  Both
+   take time logarithmic in the size of the pool.  Each free
+   block's list element is stored in its own first page, and
+   each page's entry in the pool's order map tells whether a free
+   block starts there, and of what order.  The pool's bitmap of
+   used pages is only used to catch double frees and the like.
+
+   Each pool keeps a small cache of pages that have already been
+   zeroed, so that single-page PAL_ZERO allocations, such as new
+   thread pages and zero-filled user pages, need not clear a page
+   on the spot.  The cache is refilled by low-priority work, which
+   runs only when the CPU would otherwise be idle.  Cached pages
+   are marked used in the pool's bitmap, and they are given up to
+   any allocation that could not otherwise be satisfied.
+
+   Most allocations are of single pages, so each pool also keeps
+   a LIFO cache of free pages in front of the buddy allocator.
+   Single-page allocations and frees go to the cache, which they
+   access with interrupts turned off instead of taking the pool's
+   lock.  Only when the cache runs dry is it refilled from the
+   buddy allocator, up to its low watermark, and only when it
+   reaches its high watermark is it drained back down to the low
+   watermark.  The watermarks may be set with the -pcache kernel
+   command-line option.  Cached pages are also marked used in the
+   pool's bitmap. */
+
+/* Number of buddy block orders.  The largest block, of order
+   BUDDY_ORDERS - 1, is 32,768 pages, or 128 MB. */
+#define BUDDY_ORDERS 16
+
+/* Order map entry for a page that does not start a free block. */
+#define NOT_FREE -1
+
+/* Number of pre-zeroed pages kept in each pool's cache. */
+#define ZERO_CACHE_PAGES 16
+
+/* Page cache watermarks, shared by both pools.  The cache is
+   refilled up to LOW pages when it is empty, and drained down to
+   LOW pages when it reaches HIGH pages. */
+static size_t pcache_low = 8;
+static size_t pcache_high = 32;
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct bitmap *used_map;            /* Bitmap of used pages. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+    struct heap_class heap;             /* Usage, for "-heapstat". */
+
+    /* Buddy allocator, protected by LOCK. */
+    struct list free_lists[BUDDY_ORDERS]; /* Free blocks, by order. */
+    int8_t *order_map;                  /* Order of free block at each page. */
+    size_t page_cnt;                    /* Number of pages. */
+
+    /* Cache of zeroed pages, accessed with interrupts off. */
+    void *zeroed[ZERO_CACHE_PAGES];     /* Zeroed pages. */
+    size_t zeroed_cnt;                  /* Number of pages in ZEROED. */
+    struct work zero_work;              /* Refills ZEROED. */
+    long long zero_hits;                /* PAL_ZERO pages from ZEROED. */
+    long long zero_misses;              /* PAL_ZERO pages zeroed on demand. */
+
+    /* Cache of free pages, accessed with interrupts off. */
+    void *cache[PALLOC_CACHE_MAX];        /* Free pages, most recent last. */
+    size_t cache_cnt;                   /* Number of pages in CACHE. */
+    long long cache_hits;               /* Pages allocated from CACHE. */
+    long long cache_misses;             /* Pages allocated with CACHE empty. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +112,18 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t page_idx_of (const struct pool *, const void *page);
+static void *get_pages (enum palloc_flags, size_t page_cnt,
+                        const void *caller);
+static void *get_page (struct pool *, bool zero, bool *zeroed);
+static void put_page (struct pool *, void *page);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_free_block (struct pool *, size_t page_idx, int order);
+static bool buddy_claim (struct pool *, size_t page_idx, size_t page_cnt);
+static work_func refill_zeroed;
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -61,6 +146,17 @@ palloc_init (size_t user_page_limit)
              user_pages, "user pool");
 }
 
+/* Sets the page cache watermarks to LOW and HIGH pages. */
+void
+palloc_set_cache_watermarks (size_t low, size_t high) 
+{
+  ASSERT (low < high);
+  ASSERT (high <= PALLOC_CACHE_MAX);
+
+  pcache_low = low;
+  pcache_high = high;
+}
+
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
@@ -69,27 +165,54 @@ palloc_init (size_t user_page_limit)
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
+{
+  return get_pages (flags, page_cnt, __builtin_return_address (0));
+}
+
+/* Obtains a single free page and returns its kernel virtual
+   address.
+   If PAL_USER is set, the page is obtained from the user pool,
+   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
+   then the page is filled with zeros.  If no pages are
+   available, returns a null pointer, unless PAL_ASSERT is set in
+   FLAGS, in which case the kernel panics. */
+void *
+palloc_get_page (enum palloc_flags flags) 
+{
+  return get_pages (flags, 1, __builtin_return_address (0));
+}
+
+/* Implements palloc_get_multiple(), recording the allocation as
+   made by CALLER for "-heapstat". */
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt, const void *caller)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-  void *pages;
-  size_t page_idx;
+  void *pages = NULL;
+  bool zeroed = false;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
+  if (page_cnt == 1)
+    pages = get_page (pool, flags & PAL_ZERO, &zeroed);
   else
-    pages = NULL;
+    {
+      size_t page_idx;
+
+      lock_acquire (&pool->lock);
+      page_idx = alloc_pages (pool, page_cnt);
+      if (page_idx != BITMAP_ERROR)
+        pages = pool->base + PGSIZE * page_idx;
+      lock_release (&pool->lock);
+    }
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
+      heapstat_alloc (&pool->heap, pages, PGSIZE * page_cnt, caller,
+                      !(flags & PAL_BACKING));
     }
   else 
     {
@@ -100,19 +223,6 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   return pages;
 }
 
-/* Obtains a single free page and returns its kernel virtual
-   address.
-   If PAL_USER is set, the page is obtained from the user pool,
-   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the page is filled with zeros.  If no pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
-void *
-palloc_get_page (enum palloc_flags flags) 
-{
-  return palloc_get_multiple (flags, 1);
-}
-
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
@@ -132,13 +242,20 @@ palloc_free_multiple (void *pages, size_t page_cnt)
     NOT_REACHED ();
 
   page_idx = pg_no (pages) - pg_no (pool->base);
+  heapstat_free (&pool->heap, pages);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  if (page_cnt == 1)
+    put_page (pool, pages);
+  else
+    {
+      lock_acquire (&pool->lock);
+      free_pages (pool, page_idx, page_cnt);
+      lock_release (&pool->lock);
+    }
 }
 
 /* Frees the page at PAGE. */
@@ -148,15 +265,464 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Frees all but the first NEW_CNT of the PAGE_CNT allocated
+   pages starting at PAGES. */
+void
+palloc_shrink (void *pages, size_t page_cnt, size_t new_cnt) 
+{
+  struct pool *pool;
+
+  ASSERT (new_cnt > 0 && new_cnt <= page_cnt);
+
+  if (page_from_pool (&kernel_pool, pages))
+    pool = &kernel_pool;
+  else if (page_from_pool (&user_pool, pages))
+    pool = &user_pool;
+  else
+    NOT_REACHED ();
+
+  palloc_free_multiple ((uint8_t *) pages + PGSIZE * new_cnt,
+                        page_cnt - new_cnt);
+  heapstat_resize (&pool->heap, pages, PGSIZE * new_cnt);
+}
+
+/* Tries to extend the PAGE_CNT allocated pages starting at
+   PAGES to NEW_CNT pages, by allocating the pages that follow
+   them.  Returns true if successful, false if any of those
+   pages is in use or beyond the end of the pool.  The new pages
+   are not zeroed. */
+bool
+palloc_extend (void *pages, size_t page_cnt, size_t new_cnt) 
+{
+  struct pool *pool;
+  size_t page_idx;
+  bool success;
+
+  ASSERT (pg_ofs (pages) == 0);
+  ASSERT (new_cnt >= page_cnt);
+
+  if (page_from_pool (&kernel_pool, pages))
+    pool = &kernel_pool;
+  else if (page_from_pool (&user_pool, pages))
+    pool = &user_pool;
+  else
+    NOT_REACHED ();
+
+  page_idx = page_idx_of (pool, pages) + page_cnt;
+  if (page_idx + (new_cnt - page_cnt) > pool->page_cnt)
+    return false;
+
+  lock_acquire (&pool->lock);
+  success = buddy_claim (pool, page_idx, new_cnt - page_cnt);
+  lock_release (&pool->lock);
+  if (success)
+    heapstat_resize (&pool->heap, pages, PGSIZE * new_cnt);
+  return success;
+}
+
+/* Prints statistics for POOL: how fragmented its free memory
+   is, and how well its page caches have worked. */
+static void
+print_pool_stats (struct pool *pool) 
+{
+  size_t free_pages = 0;
+  long long cache_total;
+  int order;
+
+  lock_acquire (&pool->lock);
+  printf ("Palloc: %s: free blocks by order:", pool->name);
+  for (order = 0; order < BUDDY_ORDERS; order++) 
+    {
+      size_t block_cnt = list_size (&pool->free_lists[order]);
+      printf (" %zu", block_cnt);
+      free_pages += block_cnt << order;
+    }
+  printf ("\n");
+  printf ("Palloc: %s: %zu of %zu pages free, %zu zeroed in cache\n",
+          pool->name, free_pages, pool->page_cnt, pool->zeroed_cnt);
+  printf ("Palloc: %s: %lld zeroed pages from cache, %lld zeroed on demand\n",
+          pool->name, pool->zero_hits, pool->zero_misses);
+  cache_total = pool->cache_hits + pool->cache_misses;
+  printf ("Palloc: %s: page cache: %lld hits, %lld misses (%lld%% hit), "
+          "%zu pages cached\n",
+          pool->name, pool->cache_hits, pool->cache_misses,
+          cache_total > 0 ? pool->cache_hits * 100 / cache_total : 0,
+          pool->cache_cnt);
+  lock_release (&pool->lock);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
+
+/* Allocates a single page from POOL and returns it, or a null
+   pointer if POOL is out of memory.  If ZERO is true, tries the
+   zeroed page cache first, and sets *ZEROED to true if the page
+   came from there.  Otherwise takes the page from the page
+   cache, refilling the cache from the buddy allocator if it is
+   empty. */
+static void *
+get_page (struct pool *pool, bool zero, bool *zeroed) 
+{
+  enum intr_level old_level;
+  void *page = NULL;
+  bool refill_zero = false;
+
+  old_level = intr_disable ();
+  if (zero)
+    {
+      if (pool->zeroed_cnt > 0)
+        {
+          page = pool->zeroed[--pool->zeroed_cnt];
+          *zeroed = true;
+          pool->zero_hits++;
+        }
+      else
+        pool->zero_misses++;
+      refill_zero = pool->zeroed_cnt < ZERO_CACHE_PAGES / 2;
+    }
+  if (page == NULL)
+    {
+      if (pool->cache_cnt > 0)
+        {
+          page = pool->cache[--pool->cache_cnt];
+          pool->cache_hits++;
+        }
+      else
+        pool->cache_misses++;
+    }
+  intr_set_level (old_level);
+
+  if (refill_zero)
+    work_queue (&pool->zero_work, WORK_LOW);
+
+  if (page == NULL)
+    {
+      size_t page_idx;
+
+      lock_acquire (&pool->lock);
+      page_idx = alloc_pages (pool, 1);
+      if (page_idx != BITMAP_ERROR)
+        {
+          page = pool->base + PGSIZE * page_idx;
+
+          /* Refill the cache, so that the next allocations need
+             not take the lock.  Interrupts stay off throughout,
+             which is cheap because buddy_alloc() never sleeps. */
+          old_level = intr_disable ();
+          while (pool->cache_cnt < pcache_low)
+            {
+              page_idx = buddy_alloc (pool, 1);
+              if (page_idx == BITMAP_ERROR)
+                break;
+              pool->cache[pool->cache_cnt++] = pool->base + PGSIZE * page_idx;
+            }
+          intr_set_level (old_level);
+        }
+      lock_release (&pool->lock);
+    }
+  return page;
+}
+
+/* Frees PAGE, a single page in POOL, into POOL's page cache.  If
+   the cache is full, first drains it to its low watermark. */
+static void
+put_page (struct pool *pool, void *page) 
+{
+  enum intr_level old_level;
+
+  ASSERT (bitmap_test (pool->used_map, page_idx_of (pool, page)));
+
+  old_level = intr_disable ();
+#ifndef NDEBUG
+  {
+    size_t i;
+
+    for (i = 0; i < pool->cache_cnt; i++)
+      ASSERT (pool->cache[i] != page);
+  }
+#endif
+  if (pool->cache_cnt < pcache_high)
+    {
+      pool->cache[pool->cache_cnt++] = page;
+      intr_set_level (old_level);
+      return;
+    }
+  intr_set_level (old_level);
+
+  lock_acquire (&pool->lock);
+  old_level = intr_disable ();
+  while (pool->cache_cnt > pcache_low)
+    free_pages (pool, page_idx_of (pool, pool->cache[--pool->cache_cnt]), 1);
+  pool->cache[pool->cache_cnt++] = page;
+  intr_set_level (old_level);
+  lock_release (&pool->lock);
+}
+
+/* Gives all of POOL's cached pages back to the buddy allocator.
+   Returns true if there were any.  POOL's lock must be held. */
+static bool
+drain_caches (struct pool *pool) 
+{
+  enum intr_level old_level;
+  bool drained;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  old_level = intr_disable ();
+  drained = pool->zeroed_cnt > 0 || pool->cache_cnt > 0;
+  while (pool->zeroed_cnt > 0)
+    free_pages (pool, page_idx_of (pool, pool->zeroed[--pool->zeroed_cnt]), 1);
+  while (pool->cache_cnt > 0)
+    free_pages (pool, page_idx_of (pool, pool->cache[--pool->cache_cnt]), 1);
+  intr_set_level (old_level);
+  return drained;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first one, or BITMAP_ERROR if there is no free
+   block large enough.  In that case, gives the cached pages back
+   to the buddy allocator and tries again.  POOL's lock must be
+   held. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt) 
+{
+  size_t page_idx;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  page_idx = buddy_alloc (pool, page_cnt);
+  if (page_idx == BITMAP_ERROR && drain_caches (pool))
+    page_idx = buddy_alloc (pool, page_cnt);
+  return page_idx;
+}
+
+/* Returns the index of PAGE within POOL. */
+static size_t
+page_idx_of (const struct pool *pool, const void *page) 
+{
+  return pg_no (page) - pg_no (pool->base);
+}
+
+/* Returns the first page of the free block whose list element
+   is E. */
+static size_t
+free_block_idx (const struct pool *pool, const struct list_elem *e) 
+{
+  return ((const uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Returns the list element of the free block that starts at
+   page PAGE_IDX of POOL. */
+static struct list_elem *
+free_block_elem (const struct pool *pool, size_t page_idx) 
+{
+  return (struct list_elem *) (pool->base + page_idx * PGSIZE);
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL's buddy
+   allocator and returns the index of the first one, or
+   BITMAP_ERROR if there is no free block large enough.  POOL's
+   lock must be held. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) 
+{
+  int want, order;
+  size_t page_idx;
+
+  ASSERT (page_cnt > 0);
+
+  /* Find the smallest order that fits, then the smallest free
+     block of at least that order. */
+  for (want = 0; want < BUDDY_ORDERS && ((size_t) 1 << want) < page_cnt;
+       want++)
+    continue;
+  for (order = want; order < BUDDY_ORDERS; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order >= BUDDY_ORDERS)
+    return BITMAP_ERROR;
+
+  page_idx = free_block_idx (pool, list_pop_front (&pool->free_lists[order]));
+  ASSERT (pool->order_map[page_idx] == order);
+  pool->order_map[page_idx] = NOT_FREE;
+
+  /* Split it down to the order we want, freeing the upper
+     halves, then free whatever is left over beyond PAGE_CNT. */
+  while (order > want) 
+    {
+      order--;
+      buddy_free_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+  if (page_cnt < (size_t) 1 << order)
+    buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+  ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+  return page_idx;
+}
+
+/* Frees the PAGE_CNT allocated pages starting at PAGE_IDX in
+   POOL.  POOL's lock must be held. */
+static void
+free_pages (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  buddy_free (pool, page_idx, page_cnt);
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX in POOL to the
+   buddy allocator's free lists.  The pages need not have been
+   allocated together or be a power of 2 in number: they are
+   split into the largest aligned blocks possible.  POOL's lock
+   must be held. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
+
+  while (page_cnt > 0) 
+    {
+      int order = 0;
+
+      while (order + 1 < BUDDY_ORDERS
+             && page_idx % ((size_t) 1 << (order + 1)) == 0
+             && ((size_t) 1 << (order + 1)) <= page_cnt)
+        order++;
+      buddy_free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Allocates the PAGE_CNT pages starting at PAGE_IDX in POOL,
+   which must all be free, taking them out of whichever free
+   blocks contain them.  Returns true if successful, false if
+   any of them is in use.  POOL's lock must be held. */
+static bool
+buddy_claim (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  size_t end = page_idx + page_cnt;
+  size_t idx = page_idx;
+
+  ASSERT (end <= pool->page_cnt);
+
+  /* Pages in the zeroed and page caches are marked used, so a
+     clear bit means that the page is in a free block. */
+  if (!bitmap_none (pool->used_map, page_idx, page_cnt))
+    return false;
+
+  while (idx < end) 
+    {
+      size_t block_idx, block_end;
+      int order;
+
+      /* Find the free block that contains page IDX. */
+      for (order = 0; order < BUDDY_ORDERS; order++) 
+        {
+          block_idx = idx & ~(((size_t) 1 << order) - 1);
+          if (pool->order_map[block_idx] == order)
+            break;
+        }
+      ASSERT (order < BUDDY_ORDERS);
+      block_end = block_idx + ((size_t) 1 << order);
+
+      /* Take it off the free lists and give back the parts that
+         lie outside the range we want. */
+      list_remove (free_block_elem (pool, block_idx));
+      pool->order_map[block_idx] = NOT_FREE;
+      if (block_idx < idx)
+        buddy_free (pool, block_idx, idx - block_idx);
+      if (block_end > end)
+        buddy_free (pool, end, block_end - end);
+      idx = block_end;
+    }
+
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+  return true;
+}
+
+/* Adds the free block of order ORDER at PAGE_IDX to POOL's free
+   lists, first merging it with its buddy for as long as the
+   buddy is free.  POOL's lock must be held. */
+static void
+buddy_free_block (struct pool *pool, size_t page_idx, int order) 
+{
+  ASSERT (page_idx % ((size_t) 1 << order) == 0);
+
+  while (order + 1 < BUDDY_ORDERS) 
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy_idx + ((size_t) 1 << order) > pool->page_cnt
+          || pool->order_map[buddy_idx] != order)
+        break;
+      list_remove (free_block_elem (pool, buddy_idx));
+      pool->order_map[buddy_idx] = NOT_FREE;
+      if (buddy_idx < page_idx)
+        page_idx = buddy_idx;
+      order++;
+    }
+
+  pool->order_map[page_idx] = order;
+  list_push_front (&pool->free_lists[order], free_block_elem (pool, page_idx));
+}
+
+/* Work function that fills up the zeroed page cache of pool
+   POOL_.  Pages are cleared without holding the pool's lock, so
+   that allocations can proceed meanwhile. */
+static void
+refill_zeroed (void *pool_) 
+{
+  struct pool *pool = pool_;
+
+  for (;;)
+    {
+      size_t page_idx;
+      enum intr_level old_level;
+      void *page;
+
+      lock_acquire (&pool->lock);
+      old_level = intr_disable ();
+      if (pool->zeroed_cnt >= ZERO_CACHE_PAGES)
+        page_idx = BITMAP_ERROR;
+      else
+        page_idx = buddy_alloc (pool, 1);
+      intr_set_level (old_level);
+      lock_release (&pool->lock);
+      if (page_idx == BITMAP_ERROR)
+        break;
+
+      page = pool->base + PGSIZE * page_idx;
+      memset (page, 0, PGSIZE);
+
+      lock_acquire (&pool->lock);
+      old_level = intr_disable ();
+      if (pool->zeroed_cnt < ZERO_CACHE_PAGES)
+        pool->zeroed[pool->zeroed_cnt++] = page;
+      else
+        free_pages (pool, page_idx, 1);
+      intr_set_level (old_level);
+      lock_release (&pool->lock);
+    }
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  /* We'll put the pool's used_map and order_map at its base.
+     Calculate the space needed for them and subtract it from the
+     pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t bm_pages = DIV_ROUND_UP (bm_size + page_cnt, PGSIZE);
+  int order;
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -164,9 +730,24 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  lock_init_named (&p->lock, name);
+  p->name = name;
+  heapstat_class_init (&p->heap, name);
+  p->zeroed_cnt = 0;
+  work_init (&p->zero_work, refill_zeroed, p);
+  p->zero_hits = p->zero_misses = 0;
+  p->cache_cnt = 0;
+  p->cache_hits = p->cache_misses = 0;
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->order_map = (int8_t *) base + bm_size;
+  memset (p->order_map, NOT_FREE, page_cnt);
   p->base = base + bm_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+
+  /* Put all of its pages on the free lists. */
+  for (order = 0; order < BUDDY_ORDERS; order++)
+    list_init (&p->free_lists[order]);
+  buddy_free (p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /* How to allocate pages. */
@@ -8,13 +9,21 @@ enum palloc_flags
   {
     PAL_ASSERT = 001,           /* Panic on failure. */
     PAL_ZERO = 002,             /* Zero page contents. */
-    PAL_USER = 004              /* User page. */
+    PAL_USER = 004,             /* User page. */
+    PAL_BACKING = 010           /* Backs malloc() blocks. */
   };
 
+/* Maximum page cache high watermark. */
+#define PALLOC_CACHE_MAX 64
+
 void palloc_init (size_t user_page_limit);
+void palloc_set_cache_watermarks (size_t low, size_t high);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_shrink (void *, size_t page_cnt, size_t new_cnt);
+bool palloc_extend (void *, size_t page_cnt, size_t new_cnt);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,251 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator for fixed-size kernel objects.
+
+   malloc() rounds each request up to a power of 2, so an object
+   just over a power of 2 in size wastes nearly half of its
+   block.  A slab cache instead serves objects of exactly one
+   size, rounded up only to the requested alignment.
+
+   Each slab is a single page obtained from the page allocator.
+   It begins with a header, followed by a stack of the indexes
+   of the slab's free objects, followed by the objects
+   themselves.  Keeping the free stack outside the objects means
+   that free objects are never written, so an object constructed
+   when its slab was created stays constructed across any number
+   of allocations and frees.
+
+   A cache keeps its slabs on three lists, by whether they are
+   partly used, fully used, or entirely free.  Objects are
+   allocated from partly used slabs first, so that the others
+   can drain and be given back to the page allocator.  One
+   entirely free slab is kept around, so that a cache whose
+   last object is freed and then reallocated over and over does
+   not go to the page allocator each time. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Slab header, at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of CACHE's lists. */
+    size_t free_cnt;            /* Number of free objects. */
+    uint16_t free_idx[];        /* Indexes of free objects. */
+  };
+
+/* All slab caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *new_slab (struct slab_cache *);
+static void *slab_obj (struct slab_cache *, struct slab *, size_t idx);
+
+/* Initializes cache C to allocate objects of OBJ_SIZE bytes,
+   aligned on ALIGN-byte boundaries, naming it NAME for
+   statistics.  ALIGN must be a power of 2, or 0 for word
+   alignment.  If CTOR is nonnull, it is called on each object
+   when its slab is created. */
+void
+slab_cache_init (struct slab_cache *c, const char *name,
+                 size_t obj_size, size_t align, slab_ctor_func *ctor) 
+{
+  enum intr_level old_level;
+  size_t n;
+
+  if (align == 0)
+    align = sizeof (void *);
+  ASSERT ((align & (align - 1)) == 0);
+  ASSERT (obj_size > 0);
+
+  c->name = name;
+  c->obj_size = ROUND_UP (obj_size, align);
+  c->align = align;
+  c->ctor = ctor;
+
+  /* Fit as many objects into a page as we can, along with the
+     header and the free index stack. */
+  for (n = (PGSIZE - sizeof (struct slab)) / c->obj_size; n > 0; n--) 
+    {
+      c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+                             align);
+      if (c->obj_ofs + n * c->obj_size <= PGSIZE)
+        break;
+    }
+  if (n == 0)
+    PANIC ("%s: %zu-byte objects too big for a slab", name, obj_size);
+  c->objs_per_slab = n;
+
+  lock_init_named (&c->lock, name);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->slab_cnt = c->used_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &c->elem);
+  intr_set_level (old_level);
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available. */
+void *
+slab_alloc (struct slab_cache *c) 
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else 
+    {
+      if (!list_empty (&c->empty))
+        s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      else
+        {
+          s = new_slab (c);
+          if (s == NULL) 
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  obj = slab_obj (c, s, s->free_idx[--s->free_cnt]);
+  if (s->free_cnt == 0) 
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  c->used_cnt++;
+  lock_release (&c->lock);
+
+  return obj;
+}
+
+/* Frees OBJ, which must have been allocated from cache C. */
+void
+slab_free (struct slab_cache *c, void *obj) 
+{
+  struct slab *s;
+  size_t idx;
+
+  if (obj == NULL)
+    return;
+
+  s = pg_round_down (obj);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  ASSERT ((size_t) pg_ofs (obj) >= c->obj_ofs);
+  ASSERT ((pg_ofs (obj) - c->obj_ofs) % c->obj_size == 0);
+  idx = (pg_ofs (obj) - c->obj_ofs) / c->obj_size;
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it must stay constructed. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+#ifndef NDEBUG
+  {
+    size_t i;
+
+    for (i = 0; i < s->free_cnt; i++)
+      ASSERT (s->free_idx[i] != idx);
+  }
+#endif
+  if (s->free_cnt == 0) 
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  s->free_idx[s->free_cnt++] = idx;
+  if (s->free_cnt == c->objs_per_slab) 
+    {
+      list_remove (&s->elem);
+      if (list_empty (&c->empty))
+        list_push_front (&c->empty, &s->elem);
+      else 
+        {
+          s->magic = 0;
+          palloc_free_page (s);
+          c->slab_cnt--;
+        }
+    }
+  c->used_cnt--;
+  lock_release (&c->lock);
+}
+
+/* Prints how much of the memory in each slab cache is in use. */
+void
+slab_print_stats (void) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e)) 
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, elem);
+
+      lock_acquire (&c->lock);
+      printf ("Slab: %s: %zu of %zu %zu-byte objects in use in %zu slabs, "
+              "%zu%% of slab memory\n",
+              c->name, c->used_cnt, c->slab_cnt * c->objs_per_slab,
+              c->obj_size, c->slab_cnt,
+              c->slab_cnt > 0
+              ? c->used_cnt * c->obj_size * 100 / (c->slab_cnt * PGSIZE)
+              : 0);
+      lock_release (&c->lock);
+    }
+}
+
+/* Creates and returns a new slab for cache C, with all of its
+   objects constructed and free, or returns a null pointer if
+   memory is not available.  C's lock must be held. */
+static struct slab *
+new_slab (struct slab_cache *c) 
+{
+  struct slab *s;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->free_cnt = c->objs_per_slab;
+  for (i = 0; i < c->objs_per_slab; i++) 
+    {
+      /* Hand out objects in address order. */
+      s->free_idx[i] = c->objs_per_slab - 1 - i;
+      if (c->ctor != NULL)
+        c->ctor (slab_obj (c, s, i));
+    }
+  c->slab_cnt++;
+  return s;
+}
+
+/* Returns the IDX'th object in slab S of cache C. */
+static void *
+slab_obj (struct slab_cache *c, struct slab *s, size_t idx) 
+{
+  ASSERT (idx < c->objs_per_slab);
+  return (uint8_t *) s + c->obj_ofs + idx * c->obj_size;
+}
@@ -27,10 +27,25 @@
 */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* If true, named locks keep contention statistics, which are
+   printed at shutdown.  Controlled by kernel command-line option
+   "-lockstat". */
+bool lockstat;
+
+/* List of named locks, for lock_print_stats(). */
+static struct list named_locks = LIST_INITIALIZER (named_locks);
+
+static bool is_profiled (const struct lock *);
+static void account_acquire (struct lock *, bool contended,
+                             int64_t wait_start);
+static void account_release (struct lock *);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -103,6 +118,10 @@ sema_try_down (struct semaphore *sema)
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
    and wakes up one thread of those waiting for SEMA, if any.
+   The highest-priority waiter is chosen, or the one that has
+   waited longest among waiters of equal priority.  If it has a
+   higher priority than the running thread, the CPU is yielded
+   to it.
 
    This function may be called from an interrupt handler. */
 void
@@ -114,9 +133,14 @@ sema_up (struct semaphore *sema)
 
   old_level = intr_disable ();
   if (!list_empty (&sema->waiters)) 
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
+    {
+      struct list_elem *e = list_max (&sema->waiters,
+                                      thread_priority_less, NULL);
+      list_remove (e);
+      thread_unblock (list_entry (e, struct thread, elem));
+    }
   sema->value++;
+  thread_preempt ();
   intr_set_level (old_level);
 }
 
@@ -178,13 +202,89 @@ lock_init (struct lock *lock)
   ASSERT (lock != NULL);
 
   lock->holder = NULL;
+  lock->priority = PRI_MIN - 1;
+  lock->name = NULL;
   sema_init (&lock->semaphore, 1);
 }
 
+/* Initializes LOCK like lock_init(), and gives it NAME, which
+   makes it keep contention statistics if "-lockstat" was given.
+   A named lock must never be destroyed, because it stays on the
+   list of locks whose statistics are printed at shutdown, so
+   only name locks with static storage duration or that live in
+   memory that is never freed. */
+void
+lock_init_named (struct lock *lock, const char *name) 
+{
+  enum intr_level old_level;
+
+  ASSERT (name != NULL);
+
+  lock_init (lock);
+  lock->name = name;
+  memset (&lock->stat, 0, sizeof lock->stat);
+
+  old_level = intr_disable ();
+  list_push_back (&named_locks, &lock->stat_elem);
+  intr_set_level (old_level);
+}
+
+/* Donates the priority of thread T, which is about to block
+   waiting for T->wait_lock, to the lock's holder.  If the holder
+   is itself waiting for a lock, the donation is passed along to
+   that lock's holder, and so on to the end of the chain.  Stops
+   early once a link in the chain already has at least T's
+   priority, since everything beyond it does too.  Must be called
+   with interrupts off. */
+static void
+donate_priority (struct thread *t) 
+{
+  int priority = t->priority;
+  struct lock *lock;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (lock = t->wait_lock; lock != NULL && lock->holder != NULL;
+       lock = lock->holder->wait_lock)
+    {
+      if (lock->priority >= priority)
+        break;
+      lock->priority = priority;
+      if (lock->holder->priority >= priority)
+        break;
+      thread_refresh_priority (lock->holder);
+    }
+}
+
+/* Returns the highest priority among the threads waiting for
+   LOCK, or PRI_MIN - 1 if there are none.  Must be called with
+   interrupts off. */
+static int
+lock_waiters_priority (struct lock *lock) 
+{
+  struct list *waiters = &lock->semaphore.waiters;
+  struct list_elem *e;
+  int priority = PRI_MIN - 1;
+
+  for (e = list_begin (waiters); e != list_end (waiters); e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, elem);
+      if (t->priority > priority)
+        priority = t->priority;
+    }
+  return priority;
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   If the lock is held by a lower-priority thread, the current
+   thread donates its priority to the holder (and, transitively,
+   to whatever the holder is waiting for) until the lock is
+   released, so that a low-priority holder cannot indefinitely
+   delay a high-priority waiter.
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
@@ -192,12 +292,33 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool contended;
+  int64_t wait_start = 0;
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  contended = lock->holder != NULL;
+  if (contended && !thread_mlfqs)
+    {
+      cur->wait_lock = lock;
+      donate_priority (cur);
+    }
+  if (contended && is_profiled (lock))
+    wait_start = timer_ticks ();
   sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+  cur->wait_lock = NULL;
+  lock->holder = cur;
+  if (is_profiled (lock))
+    account_acquire (lock, contended, wait_start);
+  lock->priority = lock_waiters_priority (lock);
+  list_push_back (&cur->held_locks, &lock->elem);
+  thread_refresh_priority (cur);
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -209,18 +330,31 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      struct thread *cur = thread_current ();
+      lock->holder = cur;
+      if (is_profiled (lock))
+        account_acquire (lock, false, 0);
+      lock->priority = lock_waiters_priority (lock);
+      list_push_back (&cur->held_locks, &lock->elem);
+      thread_refresh_priority (cur);
+    }
+  intr_set_level (old_level);
   return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
+   Any priority donated through LOCK is given up, which may cause
+   the current thread to yield to a waiter.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
@@ -228,11 +362,20 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  if (is_profiled (lock))
+    account_release (lock);
+  list_remove (&lock->elem);
   lock->holder = NULL;
+  lock->priority = PRI_MIN - 1;
+  thread_refresh_priority (thread_current ());
   sema_up (&lock->semaphore);
+  intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -246,13 +389,74 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
+/* Returns true if LOCK keeps contention statistics. */
+static bool
+is_profiled (const struct lock *lock) 
+{
+  return lockstat && lock->name != NULL;
+}
+
+/* Records in LOCK's statistics that it was just acquired, after
+   waiting since WAIT_START if CONTENDED.  Must be called with
+   interrupts off. */
+static void
+account_acquire (struct lock *lock, bool contended, int64_t wait_start) 
+{
+  int64_t now = timer_ticks ();
+
+  lock->stat.acquire_cnt++;
+  if (contended)
+    {
+      lock->stat.contended_cnt++;
+      lock->stat.wait_ticks += now - wait_start;
+    }
+  lock->stat.acquire_tick = now;
+}
+
+/* Records in LOCK's statistics that it is about to be released.
+   Must be called with interrupts off. */
+static void
+account_release (struct lock *lock) 
+{
+  int64_t held = timer_ticks () - lock->stat.acquire_tick;
+
+  if (held > lock->stat.max_hold_ticks)
+    lock->stat.max_hold_ticks = held;
+}
+
+/* Prints the statistics of each named lock, if "-lockstat" was
+   given. */
+void
+lock_print_stats (void) 
+{
+  struct list_elem *e;
+
+  if (!lockstat)
+    return;
+
+  for (e = list_begin (&named_locks); e != list_end (&named_locks);
+       e = list_next (e))
+    {
+      struct lock *lock = list_entry (e, struct lock, stat_elem);
+      const struct lock_stat *s = &lock->stat;
+
+      printf ("Lock %s: %lld acquires, %lld contended, "
+              "%"PRId64" ticks waited, %"PRId64" ticks max hold\n",
+              lock->name, s->acquire_cnt, s->contended_cnt,
+              s->wait_ticks, s->max_hold_ticks);
+    }
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem 
   {
     struct list_elem elem;              /* List element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
+static list_less_func cond_waiter_less;
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -295,6 +499,7 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
+  waiter.thread = thread_current ();
   list_push_back (&cond->waiters, &waiter.elem);
   lock_release (lock);
   sema_down (&waiter.semaphore);
@@ -302,14 +507,24 @@ cond_wait (struct condition *cond, struct lock *lock)
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
-   LOCK must be held before calling this function.
+   this function signals the one with the highest priority to
+   wake up from its wait.  LOCK must be held before calling this
+   function.
+
+   The signaled thread could not do anything but block again on
+   LOCK, which the caller holds, so instead of waking it up, this
+   function moves it straight from COND's wait queue to LOCK's
+   ("wait morphing"), where it donates its priority like any
+   other thread waiting for LOCK.  It then wakes up only once, when
+   LOCK is released to it.  If the thread has not blocked yet,
+   because it was preempted between releasing LOCK and going to
+   sleep in cond_wait(), it is simply signaled instead.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
    interrupt handler. */
 void
-cond_signal (struct condition *cond, struct lock *lock UNUSED) 
+cond_signal (struct condition *cond, struct lock *lock) 
 {
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
@@ -317,13 +532,59 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (lock_held_by_current_thread (lock));
 
   if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+    {
+      struct list_elem *e = list_max (&cond->waiters, cond_waiter_less, NULL);
+      struct semaphore_elem *waiter = list_entry (e, struct semaphore_elem,
+                                                  elem);
+      enum intr_level old_level;
+
+      list_remove (e);
+      old_level = intr_disable ();
+      if (!list_empty (&waiter->semaphore.waiters))
+        {
+          struct thread *t = waiter->thread;
+
+          /* Let T's sema_down() in cond_wait() return as soon as
+             T runs again, which will be when it is woken up from
+             LOCK's wait queue. */
+          ASSERT (list_front (&waiter->semaphore.waiters) == &t->elem);
+          list_remove (&t->elem);
+          waiter->semaphore.value++;
+          list_push_back (&lock->semaphore.waiters, &t->elem);
+          if (!thread_mlfqs)
+            {
+              t->wait_lock = lock;
+              donate_priority (t);
+            }
+        }
+      else
+        sema_up (&waiter->semaphore);
+      intr_set_level (old_level);
+    }
+}
+
+/* Returns true if the thread waiting on condition variable
+   waiter A_ has lower priority than the one waiting on B_. */
+static bool
+cond_waiter_less (const struct list_elem *a_, const struct list_elem *b_,
+                  void *aux UNUSED) 
+{
+  const struct semaphore_elem *a = list_entry (a_, struct semaphore_elem,
+                                               elem);
+  const struct semaphore_elem *b = list_entry (b_, struct semaphore_elem,
+                                               elem);
+
+  return a->thread->priority < b->thread->priority;
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
    LOCK).  LOCK must be held before calling this function.
 
+   As in cond_signal(), the waiters are moved to LOCK's wait
+   queue, so rather than all waking up at once to contend for
+   LOCK, they wake up one at a time, in priority order, as each
+   releases LOCK to the next.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
    interrupt handler. */
@@ -336,3 +597,181 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW as a reader-writer lock.  Any number of
+   readers may hold a reader-writer lock at once, but a writer
+   holds it alone.
+
+   Writers take precedence over readers: once a writer is
+   waiting, newly arriving readers wait too, so that a steady
+   stream of readers cannot starve writers.  In turn, when a
+   writer releases the lock, all of the readers that were
+   waiting at that moment are let in before the next writer, so
+   a steady stream of writers cannot starve readers either.
+
+   A reader may upgrade to a writer without releasing the lock
+   in between; see rwlock_upgrade().
+
+   Like a lock, a reader-writer lock is not recursive, and it
+   must not be used within an interrupt handler.  Waiting
+   threads do not donate their priority. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  cond_init (&rw->readers_ok);
+  cond_init (&rw->writer_ok);
+  cond_init (&rw->upgrade_ok);
+  rw->reader_cnt = 0;
+  rw->readers_waiting = 0;
+  rw->writers_waiting = 0;
+  rw->admitted = 0;
+  rw->read_gen = 0;
+  rw->writer = NULL;
+  rw->upgrader = NULL;
+}
+
+/* Acquires RW for reading, sleeping until it becomes available
+   if necessary: that is, until no writer holds it and no writer
+   is waiting for it, or until a writer lets this reader in as it
+   releases the lock. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rw));
+
+  lock_acquire (&rw->lock);
+  if (rw->writer != NULL || rw->writers_waiting > 0)
+    {
+      unsigned gen = rw->read_gen;
+
+      rw->readers_waiting++;
+      do
+        cond_wait (&rw->readers_ok, &rw->lock);
+      while (rw->read_gen == gen);
+      rw->readers_waiting--;
+      rw->admitted--;
+    }
+  rw->reader_cnt++;
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out lets in a waiting writer, or the upgrader
+   once it is the only reader left. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->reader_cnt > 0);
+  rw->reader_cnt--;
+  if (rw->upgrader != NULL)
+    {
+      if (rw->reader_cnt == 1)
+        cond_signal (&rw->upgrade_ok, &rw->lock);
+    }
+  else if (rw->reader_cnt == 0 && rw->admitted == 0
+           && rw->writers_waiting > 0)
+    cond_signal (&rw->writer_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it and no reader that a previous writer let in is still on its
+   way in. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rw));
+
+  lock_acquire (&rw->lock);
+  if (rw->writer != NULL || rw->reader_cnt > 0 || rw->admitted > 0)
+    {
+      rw->writers_waiting++;
+      do
+        cond_wait (&rw->writer_ok, &rw->lock);
+      while (rw->writer != NULL || rw->reader_cnt > 0 || rw->admitted > 0);
+      rw->writers_waiting--;
+    }
+  rw->writer = thread_current ();
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread must hold for writing.
+   If any readers are waiting, all of them are let in; otherwise,
+   a waiting writer, if any, is. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_for_write (rw));
+
+  lock_acquire (&rw->lock);
+  rw->writer = NULL;
+  if (rw->readers_waiting > 0)
+    {
+      rw->read_gen++;
+      rw->admitted = rw->readers_waiting;
+      cond_broadcast (&rw->readers_ok, &rw->lock);
+    }
+  else if (rw->writers_waiting > 0)
+    cond_signal (&rw->writer_ok, &rw->lock);
+  lock_release (&rw->lock);
+}
+
+/* Converts the current thread's hold on RW from reading to
+   writing, sleeping until all of the other readers have
+   released it.  The upgrading reader goes ahead of any writers
+   that were already waiting, and new readers wait behind it.
+
+   Only one reader at a time can upgrade: if two readers each
+   waited for the other to leave, neither would.  So if another
+   reader is already upgrading, returns false immediately,
+   without sleeping, and the current thread still holds RW for
+   reading.  It must then release RW and acquire it again for
+   writing, after which anything it read may have changed.
+   Returns true on success. */
+bool
+rwlock_upgrade (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+  ASSERT (rw->reader_cnt > 0);
+  if (rw->upgrader != NULL)
+    {
+      lock_release (&rw->lock);
+      return false;
+    }
+
+  rw->upgrader = thread_current ();
+  rw->writers_waiting++;
+  while (rw->reader_cnt > 1 || rw->admitted > 0)
+    cond_wait (&rw->upgrade_ok, &rw->lock);
+  rw->writers_waiting--;
+  rw->upgrader = NULL;
+  rw->reader_cnt--;
+  rw->writer = thread_current ();
+  lock_release (&rw->lock);
+  return true;
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise.  (There is no way to tell whether a given
+   thread holds a reader-writer lock for reading.) */
+bool
+rwlock_held_for_write (const struct rwlock *rw) 
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
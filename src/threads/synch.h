@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
@@ -17,18 +18,39 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Contention statistics for a named lock, kept only when the
+   kernel is run with "-lockstat".  Times are in timer ticks. */
+struct lock_stat
+  {
+    long long acquire_cnt;      /* Number of acquisitions. */
+    long long contended_cnt;    /* Acquisitions that had to wait. */
+    int64_t wait_ticks;         /* Total time spent waiting. */
+    int64_t max_hold_ticks;     /* Longest time held. */
+    int64_t acquire_tick;       /* When last acquired. */
+  };
+
 /* Lock. */
 struct lock 
   {
-    struct thread *holder;      /* Thread holding lock (for debugging). */
+    struct thread *holder;      /* Thread holding lock. */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct list_elem elem;      /* Element in holder's `held_locks' list. */
+    int priority;               /* Highest priority donated by a waiter. */
+    const char *name;           /* Name for statistics, or null. */
+    struct list_elem stat_elem; /* Element in list of named locks. */
+    struct lock_stat stat;      /* Statistics, if named. */
   };
 
+/* Keep lock statistics?  (Command-line option.) */
+extern bool lockstat;
+
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_print_stats (void);
 
 /* Condition variable. */
 struct condition 
@@ -41,6 +63,30 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock 
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition readers_ok; /* Signaled when waiting readers may enter. */
+    struct condition writer_ok; /* Signaled when a writer may enter. */
+    struct condition upgrade_ok; /* Signaled when the upgrader may enter. */
+    int reader_cnt;             /* Number of readers holding the lock. */
+    int readers_waiting;        /* Number of readers waiting. */
+    int writers_waiting;        /* Number of writers waiting. */
+    int admitted;               /* Waiting readers let in, not yet entered. */
+    unsigned read_gen;          /* Incremented to let waiting readers in. */
+    struct thread *writer;      /* Thread holding the lock for writing. */
+    struct thread *upgrader;    /* Reader waiting to upgrade, if any. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_upgrade (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include <random.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
@@ -11,6 +12,7 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -20,23 +22,48 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queues of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one queue per priority level; a ready thread T is on
+   ready_queues[T->priority].  Each queue is serviced in FIFO
+   order. */
+static struct list ready_queues[PRI_CNT];
+
+/* Bit P of ready_mask is set if and only if ready_queues[P] is
+   nonempty, so that the highest-priority ready thread can be
+   found with a bit scan instead of a search. */
+#define READY_MASK_BITS 32
+static uint32_t ready_mask[DIV_ROUND_UP (PRI_CNT, READY_MASK_BITS)];
+
+/* Number of threads in the run queues. */
+static int ready_cnt;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
+/* List of dead threads whose pages can be freed, linked through
+   their `allelem' members.  A dead thread's page cannot be freed
+   by the thread itself, which is still running on its stack, so
+   it is queued here by thread_schedule_tail() and freed later by
+   reap_threads(), in thread context. */
+static struct list reap_list;
+
+/* Threads indexed by tid, for thread_lookup(), hashed into
+   TID_BUCKET_CNT chains through their `tidelem' members.  Tids
+   are allocated sequentially, so taking them modulo the number of
+   buckets spreads live threads evenly.  A thread is in the table
+   from creation until its page is queued for reaping, so a dead
+   child remains visible to its parent until it is waited for. */
+#define TID_BUCKET_CNT 256
+static struct list tid_buckets[TID_BUCKET_CNT];
+
 /* Idle thread. */
 static struct thread *idle_thread;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
-
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
   {
@@ -49,6 +76,7 @@ struct kernel_thread_frame
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
+static unsigned wait_hist[SCHED_WAIT_BUCKETS]; /* Run-queue waits, all threads. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
@@ -59,24 +87,41 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* System load average, the estimated number of threads ready
+   to run over the past minute (MLFQS). */
+static fixed_point_t load_avg;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
 static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static int ready_max_priority (void);
+static void account_ready_wait (struct thread *);
+static void print_thread_stat (struct thread *, void *aux);
+static void print_wait_hist (const unsigned hist[SCHED_WAIT_BUCKETS]);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_update_priority (struct thread *, void *aux);
+static void mlfqs_update_recent_cpu (struct thread *, void *aux);
 static bool is_thread (struct thread *) UNUSED;
 static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static struct list *tid_bucket (tid_t);
+static void release_thread (struct thread *);
+static void reap_threads (void);
+static void queue_reap (struct thread *);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
    general and it is possible in this case only because loader.S
    was careful to put the bottom of the stack at a page boundary.
 
-   Also initializes the run queue and the tid lock.
+   Also initializes the run queues and the thread table.
 
    After calling this function, be sure to initialize the page
    allocator before trying to create any threads with
@@ -87,17 +132,23 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
-  lock_init (&tid_lock);
-  list_init (&ready_list);
+  for (i = 0; i < PRI_CNT; i++)
+    list_init (&ready_queues[i]);
+  for (i = 0; i < TID_BUCKET_CNT; i++)
+    list_init (&tid_buckets[i]);
   list_init (&all_list);
+  list_init (&reap_list);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
   init_thread (initial_thread, "main", PRI_DEFAULT);
   initial_thread->status = THREAD_RUNNING;
   initial_thread->tid = allocate_tid ();
+  list_push_back (tid_bucket (initial_thread->tid), &initial_thread->tidelem);
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -125,6 +176,7 @@ thread_tick (void)
   struct thread *t = thread_current ();
 
   /* Update statistics. */
+  t->stat.run_ticks++;
   if (t == idle_thread)
     idle_ticks++;
 #ifdef USERPROG
@@ -134,17 +186,74 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  if (thread_mlfqs)
+    mlfqs_tick (t);
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
 }
 
-/* Prints thread statistics. */
+/* Prints thread statistics: global tick counts, the run-queue
+   wait histogram over all threads, and per-thread scheduler
+   statistics for every live thread. */
 void
 thread_print_stats (void) 
 {
+  enum intr_level old_level;
+
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  printf ("Thread: run-queue wait histogram (ticks):");
+  print_wait_hist (wait_hist);
+
+  old_level = intr_disable ();
+  thread_foreach (print_thread_stat, NULL);
+  intr_set_level (old_level);
+}
+
+/* Prints the scheduler statistics of thread T. */
+static void
+print_thread_stat (struct thread *t, void *aux UNUSED) 
+{
+  printf ("Thread %d (%s): %lld run ticks, %lld ready ticks, "
+          "%u voluntary and %u involuntary switches, waits:",
+          t->tid, t->name, t->stat.run_ticks, t->stat.ready_ticks,
+          t->stat.voluntary_switches, t->stat.involuntary_switches);
+  print_wait_hist (t->stat.wait_hist);
+}
+
+/* Prints the nonempty buckets of run-queue wait histogram HIST,
+   followed by a new-line. */
+static void
+print_wait_hist (const unsigned hist[SCHED_WAIT_BUCKETS]) 
+{
+  int b;
+
+  for (b = 0; b < SCHED_WAIT_BUCKETS; b++)
+    if (hist[b] != 0)
+      {
+        if (b == 0)
+          printf (" 0:%u", hist[b]);
+        else if (b == SCHED_WAIT_BUCKETS - 1)
+          printf (" %d+:%u", 1 << (b - 1), hist[b]);
+        else
+          printf (" %d-%d:%u", 1 << (b - 1), (1 << b) - 1, hist[b]);
+      }
+  printf ("\n");
+}
+
+/* Copies thread T's scheduler statistics into *STAT. */
+void
+thread_get_stat (struct thread *t, struct sched_stat *stat) 
+{
+  enum intr_level old_level;
+
+  ASSERT (is_thread (t));
+
+  old_level = intr_disable ();
+  *stat = t->stat;
+  intr_set_level (old_level);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -159,9 +268,8 @@ thread_print_stats (void)
    scheduled.  Use a semaphore or some other form of
    synchronization if you need to ensure ordering.
 
-   The code provided sets the new thread's `priority' member to
-   PRIORITY, but no actual priority scheduling is implemented.
-   Priority scheduling is the goal of Problem 1-3. */
+   If the new thread has a higher priority than the running
+   thread, the running thread yields to it immediately. */
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
@@ -175,7 +283,9 @@ thread_create (const char *name, int priority,
 
   ASSERT (function != NULL);
 
-  /* Allocate thread. */
+  /* Allocate thread, recycling the pages of dead threads
+     first. */
+  reap_threads ();
   t = palloc_get_page (PAL_ZERO);
   if (t == NULL)
     return TID_ERROR;
@@ -189,6 +299,14 @@ thread_create (const char *name, int priority,
      member cannot be observed. */
   old_level = intr_disable ();
 
+  /* Under the MLFQS the new thread inherits its parent's nice
+     and recent_cpu values, and PRIORITY is ignored in favor of a
+     computed priority. */
+  t->nice = thread_current ()->nice;
+  t->recent_cpu = thread_current ()->recent_cpu;
+  if (thread_mlfqs)
+    mlfqs_update_priority (t, NULL);
+
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame (t, sizeof *kf);
   kf->eip = NULL;
@@ -204,17 +322,19 @@ thread_create (const char *name, int priority,
   sf->eip = switch_entry;
   sf->ebp = 0;
 
-  intr_set_level (old_level);
-
   t->parent=thread_current();
   t->process_loaded=false;
   t->process_exited=false;
   t->exit_status=0;    
 
   list_push_back(&thread_current()->child,&t->childelem);  
+  list_push_back (tid_bucket (tid), &t->tidelem);
+
+  intr_set_level (old_level);
   
   /* Add to run queue. */
   thread_unblock (t);
+  thread_preempt ();
 
   return tid;
 }
@@ -239,10 +359,12 @@ thread_block (void)
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
 
-   This function does not preempt the running thread.  This can
-   be important: if the caller had disabled interrupts itself,
-   it may expect that it can atomically unblock a thread and
-   update other data. */
+   This function does not preempt the running thread, even if T
+   has a higher priority.  This can be important: if the caller
+   had disabled interrupts itself, it may expect that it can
+   atomically unblock a thread and update other data.  Call
+   thread_preempt() afterward to give the CPU to T if it should
+   run now. */
 void
 thread_unblock (struct thread *t) 
 {
@@ -252,7 +374,7 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_push_back (&ready_list, &t->elem);
+  ready_push (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -291,10 +413,18 @@ thread_tid (void)
 }
 
 /* Deschedules the current thread and destroys it.  Never
-   returns to the caller. */
+   returns to the caller.
+
+   The thread's page is freed once it is dead and no longer
+   needed by its parent.  A user process stays around until its
+   parent collects its exit status with process_wait() or exits
+   itself; nobody waits for a kernel thread, so its page is
+   freed as soon as it is dead. */
 void
 thread_exit (void) 
 {
+  struct thread *cur = thread_current ();
+
   ASSERT (!intr_context ());
 
 #ifdef USERPROG
@@ -303,16 +433,102 @@ thread_exit (void)
   sema_up(&thread_current()->exit_lock);
 #endif
 
+  intr_disable ();
+
+  /* Our children can no longer be waited for. */
+  while (!list_empty (&cur->child))
+    {
+      struct list_elem *e = list_pop_front (&cur->child);
+      struct thread *child = list_entry (e, struct thread, childelem);
+      child->parent = NULL;
+      release_thread (child);
+    }
+
+  if (!cur->is_process)
+    {
+      if (cur->parent != NULL)
+        list_remove (&cur->childelem);
+      cur->parent = NULL;
+      cur->released = true;
+    }
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
-  intr_disable ();
-  list_remove (&thread_current()->allelem);
-  thread_current ()->status = THREAD_DYING;
+  list_remove (&cur->allelem);
+  cur->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
 }
 
+/* Tells the thread system that T's parent, which must have
+   already removed T from its `child' list, no longer needs T.
+   T's page is freed now if T is dead, or as soon as it dies
+   otherwise. */
+void
+thread_release (struct thread *t) 
+{
+  enum intr_level old_level;
+
+  ASSERT (is_thread (t));
+
+  old_level = intr_disable ();
+  release_thread (t);
+  intr_set_level (old_level);
+
+  reap_threads ();
+}
+
+/* Marks T as no longer needed by its parent, queuing it for
+   reaping if it is already dead.  A thread observed in
+   THREAD_DYING state from another thread with interrupts off has
+   already switched away for the last time, because it sets that
+   state with interrupts off immediately before doing so. */
+static void
+release_thread (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!t->released);
+
+  if (t->status == THREAD_DYING)
+    queue_reap (t);
+  else
+    t->released = true;
+}
+
+/* Removes dead thread T from the thread table and queues its
+   page to be freed by reap_threads().  Must be called with
+   interrupts off. */
+static void
+queue_reap (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_DYING);
+
+  list_remove (&t->tidelem);
+  list_push_back (&reap_list, &t->allelem);
+}
+
+/* Frees the pages of all the threads in reap_list. */
+static void
+reap_threads (void) 
+{
+  ASSERT (!intr_context ());
+
+  for (;;)
+    {
+      enum intr_level old_level = intr_disable ();
+      struct thread *t = (list_empty (&reap_list) ? NULL
+                          : list_entry (list_pop_front (&reap_list),
+                                        struct thread, allelem));
+      intr_set_level (old_level);
+
+      if (t == NULL)
+        break;
+      palloc_free_page (t);
+    }
+}
+
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 void
@@ -325,12 +541,43 @@ thread_yield (void)
 
   old_level = intr_disable ();
   if (cur != idle_thread) 
-    list_push_back (&ready_list, &cur->elem);
+    ready_push (cur);
   cur->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
 }
 
+/* Yields the CPU if a ready thread has a higher priority than
+   the running thread.  Within an external interrupt handler,
+   the yield is deferred until the handler returns. */
+void
+thread_preempt (void) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (ready_max_priority () > thread_current ()->priority)
+    {
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        thread_yield ();
+    }
+  intr_set_level (old_level);
+}
+
+/* Returns true if the thread that contains list element A_ has
+   lower priority than the one that contains B_.  Both elements
+   must be `elem' members of struct thread. */
+bool
+thread_priority_less (const struct list_elem *a_,
+                      const struct list_elem *b_, void *aux UNUSED) 
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->priority < b->priority;
+}
+
 /* Invoke function 'func' on all threads, passing along 'aux'.
    This function must be called with interrupts off. */
 void
@@ -348,49 +595,209 @@ thread_foreach (thread_action_func *func, void *aux)
     }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Returns the thread whose tid is TID, or a null pointer if
+   there is none.  A thread that has died but not yet been
+   released by its parent is still found.  This function must be
+   called with interrupts off, and the thread returned is only
+   guaranteed to stay valid while they remain off unless the
+   caller is its parent. */
+struct thread *
+thread_lookup (tid_t tid) 
+{
+  struct list *bucket = tid_bucket (tid);
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, tidelem);
+      if (t->tid == tid)
+        return t;
+    }
+  return NULL;
+}
+
+/* Recomputes T's effective priority as the larger of its base
+   priority and the priorities donated through the locks it
+   holds, moving T to the proper run queue if it is ready.  The
+   MLFQS does not use priority donation, so under it the
+   effective priority is always the base priority.  Must be
+   called with interrupts off. */
+void
+thread_refresh_priority (struct thread *t) 
+{
+  struct list_elem *e;
+  int priority;
+
+  ASSERT (is_thread (t));
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  priority = t->base_priority;
+  if (!thread_mlfqs)
+    for (e = list_begin (&t->held_locks); e != list_end (&t->held_locks);
+         e = list_next (e))
+      {
+        struct lock *lock = list_entry (e, struct lock, elem);
+        if (lock->priority > priority)
+          priority = lock->priority;
+      }
+
+  if (priority == t->priority)
+    return;
+  if (t->status == THREAD_READY)
+    {
+      ready_remove (t);
+      t->priority = priority;
+      ready_push (t);
+    }
+  else
+    t->priority = priority;
+}
+
+/* Sets the current thread's base priority to NEW_PRIORITY.  The
+   effective priority does not drop below any priority donated to
+   the thread.  Yields if the running thread no longer has the
+   highest priority.  Has no effect under the MLFQS, which
+   computes priorities itself. */
 void
 thread_set_priority (int new_priority) 
 {
-  thread_current ()->priority = new_priority;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  cur->base_priority = new_priority;
+  thread_refresh_priority (cur);
+  thread_preempt ();
+  intr_set_level (old_level);
 }
 
-/* Returns the current thread's priority. */
+/* Returns the current thread's effective priority. */
 int
 thread_get_priority (void) 
 {
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority.  Yields if the running thread no longer has the
+   highest priority. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-  /* Not yet implemented. */
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+  old_level = intr_disable ();
+  cur->nice = nice;
+  if (thread_mlfqs)
+    {
+      mlfqs_update_priority (cur, NULL);
+      thread_preempt ();
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load_avg_100 = fp_round (fp_mul_int (load_avg, 100));
+  intr_set_level (old_level);
+  return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int recent_cpu_100 = fp_round (fp_mul_int (thread_current ()->recent_cpu,
+                                             100));
+  intr_set_level (old_level);
+  return recent_cpu_100;
+}
+
+/* Updates the MLFQS scheduling state at a timer tick, in which
+   CUR is the running thread.
+
+   Only the running thread's recent_cpu changes from tick to
+   tick, so it is the only thread whose priority can change
+   between the once-per-second recalculations; recomputing just
+   its priority every TIME_SLICE ticks keeps the per-tick cost
+   independent of the number of threads.  Once per second,
+   load_avg and every thread's recent_cpu and priority are
+   recomputed. */
+static void
+mlfqs_tick (struct thread *cur) 
+{
+  int64_t ticks = timer_ticks ();
+
+  if (cur != idle_thread)
+    cur->recent_cpu = fp_add_int (cur->recent_cpu, 1);
+
+  if (ticks % TIMER_FREQ == 0)
+    {
+      int ready_threads = ready_cnt + (cur != idle_thread);
+
+      load_avg = fp_div_int (fp_add (fp_mul_int (load_avg, 59),
+                                     fp_from_int (ready_threads)), 60);
+      thread_foreach (mlfqs_update_recent_cpu, NULL);
+      thread_foreach (mlfqs_update_priority, NULL);
+      thread_preempt ();
+    }
+  else if (ticks % TIME_SLICE == 0)
+    mlfqs_update_priority (cur, NULL);
+}
+
+/* Recomputes T's MLFQS priority from its recent_cpu and nice
+   values, moving T to the proper run queue if it is ready. */
+static void
+mlfqs_update_priority (struct thread *t, void *aux UNUSED) 
+{
+  int priority;
+
+  if (t == idle_thread)
+    return;
+
+  priority = fp_to_int (fp_sub (fp_from_int (PRI_MAX - t->nice * 2),
+                                fp_div_int (t->recent_cpu, 4)));
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+
+  t->base_priority = priority;
+  thread_refresh_priority (t);
+}
+
+/* Decays T's recent_cpu value according to the load average. */
+static void
+mlfqs_update_recent_cpu (struct thread *t, void *aux UNUSED) 
+{
+  fixed_point_t twice_load = fp_mul_int (load_avg, 2);
+  fixed_point_t decay = fp_div (twice_load, fp_add_int (twice_load, 1));
+
+  if (t == idle_thread)
+    return;
+
+  t->recent_cpu = fp_add_int (fp_mul (decay, t->recent_cpu), t->nice);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -400,8 +807,8 @@ thread_get_recent_cpu (void)
    point it initializes idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
-   ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   run queues.  It is returned by next_thread_to_run() as a
+   special case when all of the run queues are empty. */
 static void
 idle (void *idle_started_ UNUSED) 
 {
@@ -415,6 +822,11 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nothing is ready to run, so in tickless mode there is no
+         need to take a timer interrupt until the next sleeper is
+         due. */
+      timer_idle ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -476,12 +888,15 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
+  t->priority = t->base_priority = priority;
+  list_init (&t->held_locks);
   
   list_init(&t->child);  
   sema_init(&t->exit_lock,0);
   sema_init(&t->load_lock,0);
   t->next_fd=3;
+  list_init(&t->mmap_list);
+  t->next_mapid=1;
   
   t->magic = THREAD_MAGIC;
   list_push_back (&all_list, &t->allelem);
@@ -501,18 +916,87 @@ alloc_frame (struct thread *t, size_t size)
   return t->stack;
 }
 
+/* Adds ready thread T to the back of the run queue for its
+   priority. */
+static void
+ready_push (struct thread *t) 
+{
+  int pri = t->priority;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= pri && pri <= PRI_MAX);
+
+  list_push_back (&ready_queues[pri], &t->elem);
+  ready_cnt++;
+  if (t->status != THREAD_READY)
+    t->ready_since = timer_ticks ();
+  ready_mask[pri / READY_MASK_BITS] |= 1u << (pri % READY_MASK_BITS);
+}
+
+/* Removes ready thread T from its run queue. */
+static void
+ready_remove (struct thread *t) 
+{
+  int pri = t->priority;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_remove (&t->elem);
+  ready_cnt--;
+  if (list_empty (&ready_queues[pri]))
+    ready_mask[pri / READY_MASK_BITS] &= ~(1u << (pri % READY_MASK_BITS));
+}
+
+/* Returns the priority of the highest-priority nonempty run
+   queue, or PRI_MIN - 1 if every run queue is empty. */
+static int
+ready_max_priority (void) 
+{
+  int i;
+
+  for (i = sizeof ready_mask / sizeof *ready_mask - 1; i >= 0; i--)
+    if (ready_mask[i] != 0)
+      return (i * READY_MASK_BITS
+              + (READY_MASK_BITS - 1 - __builtin_clz (ready_mask[i])));
+  return PRI_MIN - 1;
+}
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   idle_thread.
+
+   The thread chosen is the one at the front of the
+   highest-priority nonempty run queue. */
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  int pri = ready_max_priority ();
+  struct thread *t;
+
+  if (pri < PRI_MIN)
     return idle_thread;
-  else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+
+  t = list_entry (list_front (&ready_queues[pri]), struct thread, elem);
+  ready_remove (t);
+  account_ready_wait (t);
+  return t;
+}
+
+/* Charges thread T, which is about to run, for the time it spent
+   waiting in the run queue. */
+static void
+account_ready_wait (struct thread *t) 
+{
+  int64_t wait = timer_ticks () - t->ready_since;
+  int b;
+
+  for (b = 0; b < SCHED_WAIT_BUCKETS - 1 && wait >= (1 << b); b++)
+    continue;
+  t->stat.ready_ticks += wait;
+  t->stat.wait_hist[b]++;
+  wait_hist[b]++;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -549,15 +1033,19 @@ thread_schedule_tail (struct thread *prev)
   process_activate ();
 #endif
 
-  /* If the thread we switched from is dying, destroy its struct
-     thread.  This must happen late so that thread_exit() doesn't
-     pull out the rug under itself.  (We don't free
+  /* If the thread we switched from is dying and its parent no
+     longer needs it, queue its struct thread to be destroyed.
+     This must happen late so that thread_exit() doesn't pull out
+     the rug under itself.  The page is freed later, by
+     reap_threads(), rather than here, where interrupts are off
+     and the thread switch is not yet complete.  (We don't free
      initial_thread because its memory was not obtained via
      palloc().) */
-  if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
+  if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread
+      && prev->released) 
     {
       ASSERT (prev != cur);
-      //palloc_free_page (prev);
+      queue_reap (prev);
     }
 }
 
@@ -580,23 +1068,42 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      if (cur == idle_thread)
+        timer_idle_exit ();
+      if (cur->status == THREAD_READY)
+        cur->stat.involuntary_switches++;
+      else
+        cur->stat.voluntary_switches++;
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
-/* Returns a tid to use for a new thread. */
+/* Returns a tid to use for a new thread.  Disabling interrupts
+   is enough to make the increment atomic on a uniprocessor, and
+   unlike a lock it does not need a thread to block on, so this
+   also works before the first thread exists. */
 static tid_t
 allocate_tid (void) 
 {
   static tid_t next_tid = 1;
+  enum intr_level old_level;
   tid_t tid;
 
-  lock_acquire (&tid_lock);
+  old_level = intr_disable ();
   tid = next_tid++;
-  lock_release (&tid_lock);
+  intr_set_level (old_level);
 
   return tid;
 }
+
+/* Returns the thread table bucket for TID. */
+static struct list *
+tid_bucket (tid_t tid) 
+{
+  return &tid_buckets[(unsigned) tid % TID_BUCKET_CNT];
+}
 
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
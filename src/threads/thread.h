@@ -3,7 +3,9 @@
 
 #include <debug.h>
 #include <list.h>
+#include <sched-stat.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/synch.h"
 #include "filesys/file.h"
 #include "lib/kernel/hash.h"
@@ -26,6 +28,12 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1) /* Number of priority levels. */
+
+/* Thread niceness, for the multi-level feedback queue scheduler. */
+#define NICE_MIN -20                    /* Least nice (highest priority). */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Nicest (lowest priority). */
 
 /* A kernel thread or user process.
 
@@ -79,10 +87,11 @@ typedef int tid_t;
    value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
    the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
-   ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+   semaphore wait list (synch.c) or the sleep list (timer.c).  It
+   can be used these ways only because they are mutually
+   exclusive: only a thread in the ready state is on the run
+   queue, whereas only a thread in the blocked state is on a
+   semaphore wait list or the sleep list. */
 struct thread
   {
     /* Owned by thread.c. */
@@ -90,11 +99,22 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority before donation. */
+    int nice;                           /* Niceness (MLFQS). */
+    fixed_point_t recent_cpu;           /* Recent CPU time used (MLFQS). */
     struct list_elem allelem;           /* List element for all threads list. */
+    struct list_elem tidelem;           /* List element for thread table. */
+    struct sched_stat stat;             /* Scheduler statistics. */
+    int64_t ready_since;                /* Tick at which it last became ready. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct list held_locks;             /* Locks held, for donation. */
+    struct lock *wait_lock;             /* Lock being waited for, if any. */
+
+    /* Owned by devices/timer.c. */
+    int64_t wakeup_tick;                /* Tick to wake up at, if sleeping. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -106,11 +126,16 @@ struct thread
 	
 	bool process_loaded;
 	bool process_exited;
+	bool is_process;                    /* Parent may wait for it. */
+	bool released;                      /* Parent no longer needs it. */
 	struct semaphore exit_lock;
 	struct semaphore load_lock;
 	int exit_status;
 	
 	struct hash vm;
+	void *esp;                          /* User esp on syscall entry. */
+	struct list mmap_list;              /* Memory-mapped files. */
+	int next_mapid;                     /* Next mapping identifier. */
 	
 	struct file *fdt[128];
 	int next_fd;
@@ -131,6 +156,7 @@ void thread_start (void);
 
 void thread_tick (void);
 void thread_print_stats (void);
+void thread_get_stat (struct thread *, struct sched_stat *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -143,11 +169,17 @@ tid_t thread_tid (void);
 const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
+void thread_release (struct thread *);
 void thread_yield (void);
+void thread_preempt (void);
+void thread_refresh_priority (struct thread *);
+bool thread_priority_less (const struct list_elem *,
+                           const struct list_elem *, void *aux);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func (struct thread *t, void *aux);
 void thread_foreach (thread_action_func *, void *);
+struct thread *thread_lookup (tid_t);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
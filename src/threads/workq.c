@@ -0,0 +1,192 @@
+#include "threads/workq.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Kernel work queues.  Lets code that must not sleep or must
+   return quickly, above all interrupt handlers, hand off work to
+   be done later in a kernel thread: a "bottom half".
+
+   Queued work is run by a fixed pool of worker threads.  An idle
+   worker waits at PRI_MAX, so that it runs as soon as it is woken
+   up, takes a batch of up to WORK_BATCH items off the highest
+   non-empty queue in one go, and then drops to that queue's
+   priority to run them.  So high-priority work preempts ordinary
+   threads, while low-priority work only runs when the CPU would
+   otherwise be idle.  A worker running low-priority work may not
+   run again for as long as the CPU stays busy, so one worker
+   never takes it, leaving a worker free for the other queues.
+   (The MLFQS ignores thread_set_priority(),
+   so under it workers are scheduled like any other thread.)
+   Work functions run with interrupts on, and they may sleep. */
+
+/* Number of worker threads. */
+#define WORKER_CNT 2
+
+/* Maximum number of items a worker takes at a time. */
+#define WORK_BATCH 8
+
+/* Thread priority at which to run each work priority. */
+static const int work_thread_priority[WORK_PRI_CNT] =
+  {
+    PRI_MIN,                    /* WORK_LOW. */
+    PRI_DEFAULT,                /* WORK_NORMAL. */
+    PRI_MAX - 1,                /* WORK_HIGH. */
+  };
+
+/* Queued work, one list per priority.  Accessed only with
+   interrupts off, since work may be queued by interrupt
+   handlers.  Statically initialized, so that work may be queued
+   even before workq_init(), to run once the workers start. */
+static struct list queues[WORK_PRI_CNT] =
+  {
+    LIST_INITIALIZER (queues[WORK_LOW]),
+    LIST_INITIALIZER (queues[WORK_NORMAL]),
+    LIST_INITIALIZER (queues[WORK_HIGH]),
+  };
+
+/* Idle workers, blocked, linked through their `elem' members. */
+static struct list idle_workers = LIST_INITIALIZER (idle_workers);
+
+/* Number of workers running WORK_LOW batches.  At most
+   WORKER_CNT - 1.  Accessed only with interrupts off. */
+static int low_workers;
+
+static thread_func worker;
+static int take_batch (struct list *batch);
+
+/* Starts the worker threads.  Must be called after
+   thread_start(). */
+void
+workq_init (void) 
+{
+  int i;
+
+  for (i = 0; i < WORKER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      if (thread_create (name, PRI_MAX, worker, NULL) == TID_ERROR)
+        PANIC ("couldn't create work queue thread");
+    }
+}
+
+/* Initializes WORK to call FUNC, passing AUX, when it is run. */
+void
+work_init (struct work *work, work_func *func, void *aux) 
+{
+  ASSERT (work != NULL);
+  ASSERT (func != NULL);
+
+  work->func = func;
+  work->aux = aux;
+  work->pending = false;
+}
+
+/* Queues WORK to be run by a worker thread at priority PRIORITY.
+   Returns true if successful, false if WORK was already queued
+   and has not started running yet, in which case it will still
+   run only once.  Once WORK has started, it may be queued again,
+   even by its own work function.
+
+   May be called from an interrupt handler. */
+bool
+work_queue (struct work *work, enum work_priority priority) 
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (work != NULL);
+  ASSERT (priority >= 0 && priority < WORK_PRI_CNT);
+
+  old_level = intr_disable ();
+  if (!work->pending) 
+    {
+      work->pending = true;
+      list_push_back (&queues[priority], &work->elem);
+      if (!list_empty (&idle_workers))
+        {
+          thread_unblock (list_entry (list_pop_front (&idle_workers),
+                                      struct thread, elem));
+          thread_preempt ();
+        }
+      queued = true;
+    }
+  intr_set_level (old_level);
+
+  return queued;
+}
+
+/* Worker thread. */
+static void
+worker (void *aux UNUSED) 
+{
+  for (;;) 
+    {
+      struct list batch;
+      enum intr_level old_level;
+      int priority;
+
+      /* Wait for work, then take a batch of it. */
+      list_init (&batch);
+      old_level = intr_disable ();
+      while ((priority = take_batch (&batch)) < 0)
+        {
+          list_push_back (&idle_workers, &thread_current ()->elem);
+          thread_block ();
+        }
+      if (priority == WORK_LOW)
+        low_workers++;
+      intr_set_level (old_level);
+
+      /* Run it at the proper priority. */
+      thread_set_priority (work_thread_priority[priority]);
+      while (!list_empty (&batch))
+        {
+          struct work *work = list_entry (list_pop_front (&batch),
+                                          struct work, elem);
+          work->func (work->aux);
+        }
+      thread_set_priority (PRI_MAX);
+
+      if (priority == WORK_LOW) 
+        {
+          old_level = intr_disable ();
+          low_workers--;
+          intr_set_level (old_level);
+        }
+    }
+}
+
+/* Moves up to WORK_BATCH items from the highest-priority
+   non-empty work queue to BATCH, marking them no longer pending.
+   Skips the WORK_LOW queue if all but one worker are already
+   running low-priority work.  Returns the items' priority, or -1
+   if there is no work to take.  Must be called with interrupts
+   off. */
+static int
+take_batch (struct list *batch) 
+{
+  int priority;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (priority = WORK_PRI_CNT - 1; priority >= 0; priority--)
+    if (!list_empty (&queues[priority])
+        && (priority != WORK_LOW || low_workers < WORKER_CNT - 1))
+      {
+        struct list *queue = &queues[priority];
+        int i;
+
+        for (i = 0; i < WORK_BATCH && !list_empty (queue); i++)
+          {
+            struct work *work = list_entry (list_pop_front (queue),
+                                            struct work, elem);
+            work->pending = false;
+            list_push_back (batch, &work->elem);
+          }
+        return priority;
+      }
+  return -1;
+}
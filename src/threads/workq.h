@@ -0,0 +1,36 @@
+#ifndef THREADS_WORKQ_H
+#define THREADS_WORKQ_H
+
+#include <list.h>
+#include <stdbool.h>
+
+/* Work queue priorities.  Each has its own queue, and workers
+   always take work from the highest-priority queue that has
+   any. */
+enum work_priority
+  {
+    WORK_LOW,                   /* Runs only when nothing else will. */
+    WORK_NORMAL,                /* Runs like an ordinary thread. */
+    WORK_HIGH,                  /* Runs ahead of ordinary threads. */
+    WORK_PRI_CNT                /* Number of work priorities. */
+  };
+
+/* Performs a unit of deferred work, given the AUX passed to
+   work_init(). */
+typedef void work_func (void *aux);
+
+/* A unit of deferred work.  Owned by its user, who must keep it
+   alive while it is queued. */
+struct work
+  {
+    struct list_elem elem;      /* Element in a work queue. */
+    work_func *func;            /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Queued and not yet started? */
+  };
+
+void workq_init (void);
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct work *, enum work_priority);
+
+#endif /* threads/workq.h */
@@ -5,6 +5,8 @@
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "userprog/syscall.h"
+#include "userprog/process.h"
+#include "vm/frame.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -150,9 +152,15 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  if(!not_present) syscall_exit(-1);
-  vme=check_addr(fault_addr, f->esp);
-  if(vme!=NULL&& !handle_mm_fault(vme)) syscall_exit(-1);
+  vme=check_addr(fault_addr, user ? f->esp : thread_current ()->esp);
+
+  /* The only rights violation we handle is the first write to a
+     zero-fill page that maps the shared zero frame. */
+  if (!not_present && !(write && vme->writable
+                        && frame_is_zero (vme->frame)))
+    syscall_exit (-1);
+  if (!handle_mm_fault (vme, write))
+    syscall_exit (-1);
 	
 //  syscall_exit(-1);
   
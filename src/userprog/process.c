@@ -14,11 +14,21 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
 
 //static void gdbstp(void){printf("???\n");}
+/* Maximum size of a user stack, in bytes.  Set by "-stack". */
+size_t stack_limit = 8 * 1024 * 1024;
+
+/* Number of stack pages added by each fault that grows the
+   stack. */
+#define STACK_FAULT_AROUND 4
+
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
@@ -30,20 +40,28 @@ static bool load (const char *cmdline, void (**eip) (void), void **esp);
  
 struct thread * get_child_process(int pid)
 {
-	struct list_elem * dum=list_begin(&thread_current()->child);
-	while(dum!=list_end(&thread_current()->child))
-	{
-		struct thread * dum_t=list_entry(dum,struct thread, childelem);
-		if(dum_t->tid==pid) return dum_t;
-		dum=list_next(dum);
-	}
-	return NULL;
+	/* Look the thread up in the thread table rather than scanning
+	   our child list.  Kernel-thread children detach themselves
+	   when they exit, so check the parent with interrupts off;
+	   once that check passes, the child cannot be freed until we
+	   release it. */
+	enum intr_level old_level=intr_disable();
+	struct thread * found=thread_lookup(pid);
+	if(found!=NULL && found->parent!=thread_current())
+		found=NULL;
+	intr_set_level(old_level);
+	return found;
 }
 
+/* Removes exited child CP from the current process's children
+   and lets the thread system free its page. */
 void remove_child_process(struct thread *cp)
 {
+	enum intr_level old_level=intr_disable();
 	list_remove(&cp->childelem);
-	palloc_free_page(cp);
+	cp->parent=NULL;
+	intr_set_level(old_level);
+	thread_release(cp);
 }
  
 tid_t
@@ -57,11 +75,16 @@ process_execute (const char *file_name)
   /* Make a copy of FILE_NAME.
      Otherwise there's a race between the caller and load(). */
   fn_copy = palloc_get_page (0);
-  cpy_file_name = malloc(256);
   if (fn_copy == NULL)
     return TID_ERROR;
+  cpy_file_name = malloc(256);
+  if (cpy_file_name == NULL)
+    {
+      palloc_free_page (fn_copy);
+      return TID_ERROR;
+    }
   strlcpy (fn_copy, file_name, PGSIZE);
-  strlcpy (cpy_file_name,file_name, PGSIZE);
+  strlcpy (cpy_file_name,file_name, 256);
   char * save_ptr;
   proc_name=strtok_r(cpy_file_name," ", &save_ptr);
   /* Create a new thread to execute FILE_NAME. */
@@ -72,7 +95,11 @@ process_execute (const char *file_name)
   struct thread * child=get_child_process(tid);
   if(child==NULL) return -1;
   sema_down(&child->load_lock);
-  if(!child->process_loaded) return -1;
+  if(!child->process_loaded)
+  {
+	process_wait(tid);
+	return -1;
+  }
   
   return tid;
 }
@@ -90,6 +117,9 @@ start_process (void *file_name_)
   
   char * save_ptr;
   
+  /* Must come first: until it is set, we could be freed as soon
+     as we exit, while our parent still refers to us. */
+  thread_current()->is_process=true;
   vm_init(&thread_current()->vm); //initialize hash table.
   
   cpy_file_name=malloc(256);
@@ -218,7 +248,10 @@ process_exit (void)
 	cur->fdt[i]=NULL;
   }
   
+  vm_munmap_all ();
   vm_destroy(&cur->vm);
+  file_close(cur->file_running);
+  cur->file_running=NULL;
 	  
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
@@ -443,8 +476,14 @@ load (const char *file_name, void (**eip) (void), void **esp)
   success = true;
 
  done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
+  /* We arrive here whether the load is successful or not.  On
+     success the executable stays open, and write-protected, as
+     the backing file of its pages until process_exit(). */
+  if (!success)
+    {
+      file_close (file);
+      t->file_running = NULL;
+    }
   return success;
 }
 
@@ -518,7 +557,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
-  struct file *file2= file_reopen(file);
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -549,53 +587,51 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 //          return false; 
 //        }
 
-	  struct vm_entry * vme=malloc(sizeof(struct vm_entry));
-	  memset (vme, 0, sizeof (struct vm_entry));
-	  vme->type=VM_BIN;
-	  vme->vaddr=upage; 
-	  vme->writable=writable;
-	  vme->is_loaded=false; 
-	  vme->file=file2;
-	  vme->offset=ofs; 
-	  vme->read_bytes=(read_bytes < PGSIZE)? read_bytes:PGSIZE;
-	  vme->zero_bytes=PGSIZE-vme->read_bytes;
-	  insert_vme(&thread_current()->vm,vme);
+	  /* A page with nothing to read, such as the bulk of a large
+	     BSS, is zero-fill and needs no file. */
+	  struct vm_entry * vme=vme_create(page_read_bytes>0?VM_BIN:VM_ANON,
+	                                   upage,writable);
+	  if(vme==NULL) return false;
+	  if(page_read_bytes>0)
+	    {
+	      vme->file=file;
+	      vme->offset=ofs;
+	      vme->read_bytes=page_read_bytes;
+	      vme->zero_bytes=page_zero_bytes;
+	    }
+	  if(!insert_vme(&thread_current()->vm,vme))
+	    {
+	      vme_destroy(vme);
+	      return false;
+	    }
 
       /* Advance. */
       read_bytes -= page_read_bytes;
       zero_bytes -= page_zero_bytes;
       upage += PGSIZE;
-	  ofs += vme->read_bytes;
+	  ofs += page_read_bytes;
     }
   return true;
 }
 
-/* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+/* Create a minimal stack by adding a zero-fill page at the top
+   of user virtual memory.  It gets a frame when the arguments are
+   pushed onto it. */
 static bool
 setup_stack (void **esp) 
 {
-  uint8_t *kpage;
-  bool success = false;
-  
-  struct vm_entry * vme=(struct vm_entry *) malloc(sizeof(struct vm_entry));
-  if(vme==NULL) return false;
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if (kpage != NULL) 
+  struct vm_entry *vme;
+
+  vme = vme_create (VM_ANON, ((uint8_t *) PHYS_BASE) - PGSIZE, true);
+  if (vme == NULL)
+    return false;
+  if (!insert_vme (&thread_current ()->vm, vme))
     {
-      success = install_page (pg_round_down(
-			((uint8_t *) PHYS_BASE) - PGSIZE), kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else
-        palloc_free_page (kpage);
+      vme_destroy (vme);
+      return false;
     }
-  vme->vaddr=pg_round_down(((uint8_t *) PHYS_BASE) - PGSIZE); 
-  vme->type=VM_ANON;
-  vme->writable=true;
-  vme->is_loaded=true; 
-  
-  return success=insert_vme(&thread_current()->vm,vme);
+  *esp = PHYS_BASE;
+  return true;
 }
 
 /* Adds a mapping from user virtual address UPAGE to kernel
@@ -618,24 +654,115 @@ install_page (void *upage, void *kpage, bool writable)
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
 
+/* Brings VME's page into a frame, from its file or from swap,
+   evicting another page if memory is full, and maps it.  WRITE
+   is true if the faulting access was a write.  A zero-fill page
+   that is only read maps the shared zero frame instead, and gets
+   a frame of its own on the first write.  Returns true if
+   successful. */
 bool 
-handle_mm_fault(struct vm_entry * vme)
+handle_mm_fault (struct vm_entry *vme, bool write)
 {
-	void *kaddr=palloc_get_page(PAL_USER | PAL_ZERO);
-	switch(vme->type)
-	{
-		case VM_BIN :
-		case VM_FILE :
-			if(load_file(kaddr,vme))
-			{
-				if(install_page(vme->vaddr,kaddr,vme->writable))
-				{
-					vme->is_loaded=true;
-					return true;
-				}
-			}
-			return false;
-		case VM_ANON :
-			return true;
-	}
-}
\ No newline at end of file
+  struct frame *f;
+  bool success = false;
+
+  /* Only VME's owner maps and unmaps the zero frame, so this test
+     needs no lock. */
+  if (frame_is_zero (vme->frame))
+    frame_free (vme);
+  else if (!write && frame_map_zero (vme))
+    return true;
+
+  f = frame_alloc (vme->type == VM_ANON && vme->swap_slot == SWAP_ERROR
+                   ? PAL_ZERO : 0, vme);
+  if (f == NULL)
+    return false;
+
+  switch (vme->type)
+    {
+    case VM_BIN:
+    case VM_FILE:
+      success = load_file (f->kaddr, vme);
+      break;
+    case VM_ANON:
+      if (vme->swap_slot != SWAP_ERROR)
+        {
+          swap_in (vme->swap_slot, f->kaddr);
+          vme->swap_slot = SWAP_ERROR;
+        }
+      success = true;
+      break;
+    }
+
+  if (success && install_page (vme->vaddr, f->kaddr, vme->writable))
+    {
+      vme->is_loaded = true;
+      frame_unpin (f);
+      return true;
+    }
+  frame_free (vme);
+  return false;
+}
+
+/* Grows the running process's stack to cover ADDR, if ADDR looks
+   like a stack access by a process whose stack pointer is ESP,
+   and returns the new zero-fill entry for ADDR's page.  Returns a
+   null pointer if ADDR is not a plausible stack address or memory
+   is not available.
+
+   An access is plausible if it is within the stack limit and no
+   more than 32 bytes below ESP, since PUSHA checks its access
+   before decrementing the stack pointer.  A program that pushes
+   through one page keeps going, so up to STACK_FAULT_AROUND - 1
+   pages below ADDR's page are added too, and given zeroed frames
+   right away if any are free, to save the faults that the
+   following pushes would take. */
+struct vm_entry *
+grow_stack (void *addr, void *esp)
+{
+  struct hash *vm = &thread_current ()->vm;
+  uint8_t *stack_bottom = (uint8_t *) PHYS_BASE - stack_limit;
+  uint8_t *upage = pg_round_down (addr);
+  struct vm_entry *first = NULL;
+  int i;
+
+  if ((uint8_t *) addr < stack_bottom || (uint8_t *) addr < (uint8_t *) esp - 32
+      || !is_user_vaddr (addr))
+    return NULL;
+
+  for (i = 0; i < STACK_FAULT_AROUND && upage >= stack_bottom;
+       i++, upage -= PGSIZE) 
+    {
+      struct vm_entry *vme;
+      struct frame *f;
+
+      if (find_vme (upage) != NULL)
+        break;
+      vme = vme_create (VM_ANON, upage, true);
+      if (vme == NULL)
+        break;
+      if (!insert_vme (vm, vme)) 
+        {
+          vme_destroy (vme);
+          break;
+        }
+      if (i == 0) 
+        {
+          /* The caller brings in this page. */
+          first = vme;
+          continue;
+        }
+
+      f = frame_try_alloc (PAL_ZERO, vme);
+      if (f == NULL)
+        break;
+      if (!install_page (upage, f->kaddr, true)) 
+        {
+          frame_free (vme);
+          break;
+        }
+      vme->is_loaded = true;
+      frame_unpin (f);
+    }
+  return first;
+}
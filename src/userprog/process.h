@@ -11,7 +11,11 @@ int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 int process_add_file(struct file*);
-bool handle_mm_fault(struct vm_entry *);
+bool handle_mm_fault (struct vm_entry *, bool write);
+struct vm_entry *grow_stack (void *addr, void *esp);
+
+/* Maximum size of a user stack, in bytes. */
+extern size_t stack_limit;
 
 
 #endif /* userprog/process.h */
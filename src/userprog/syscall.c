@@ -1,5 +1,7 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
+#include <sched-stat.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -15,7 +17,7 @@ static void syscall_handler (struct intr_frame *);
 void
 syscall_init (void) 
 {
-  lock_init(&filesys_lock);
+  lock_init_named(&filesys_lock, "filesys");
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
@@ -25,6 +27,23 @@ int syscall_exec(const char * cmd_line)
 	return tid;
 }
 
+/* Copies the scheduler statistics of process PID, which must be
+   the calling process or one of its children, to user buffer
+   STAT, which must be writable.  ESP is the caller's stack
+   pointer.  Returns false if there is no such process. */
+bool syscall_schedstat(int pid, struct sched_stat *stat, void *esp)
+{
+	struct sched_stat kstat;
+	struct thread * t;
+	check_valid_buffer(stat, sizeof *stat, esp, true);
+	if(pid==thread_current()->tid) t=thread_current();
+	else t=get_child_process(pid);
+	if(t==NULL) return false;
+	thread_get_stat(t, &kstat);
+	memcpy(stat, &kstat, sizeof kstat);
+	return true;
+}
+
 void syscall_exit(int exit_status)
 {
 	printf("%s: exit(%d)\n", thread_current()->name, exit_status);
@@ -38,6 +57,7 @@ check_addr(void * addr, void * esp)
 {
 	if(!is_user_vaddr(addr)) syscall_exit(-1);
 	struct vm_entry *res=find_vme(addr);
+	if(res==NULL && esp!=NULL) res=grow_stack(addr, esp);
 	if(res==NULL) syscall_exit(-1);
 	return res;	
 }
@@ -46,7 +66,12 @@ static void
 syscall_handler (struct intr_frame *f) 
 {
   void *esp=f->esp;
-  int number=*(int *) esp;
+  int number;
+
+  /* Saved for page faults taken in the kernel on user memory,
+     whose interrupt frames do not have the user's esp. */
+  thread_current()->esp=esp;
+  number=*(int *) esp;
   struct file* dum_file;
   int fd;
   switch(number)
@@ -167,5 +192,26 @@ syscall_handler (struct intr_frame *f)
 		}
 		else syscall_exit(-1);
 		break;
+	  case SYS_MMAP:                   /* Map a file into memory. */
+		check_addr(esp+4, esp);
+		check_addr(esp+8, esp);
+		fd=*(int *)(esp+4);
+		if(fd>=2 && fd<128 && thread_current()->fdt[fd]!=NULL)
+		{
+			lock_acquire(&filesys_lock);
+			f->eax=vm_mmap(thread_current()->fdt[fd],*(void **)(esp+8));
+			lock_release(&filesys_lock);
+		}
+		else f->eax=-1;
+		break;
+	  case SYS_MUNMAP:                 /* Remove a memory mapping. */
+		check_addr(esp+4, esp);
+		vm_munmap(*(int *)(esp+4));
+		break;
+	  case SYS_SCHEDSTAT:              /* Obtain scheduler statistics. */
+		check_addr(esp+4, esp);
+		check_addr(esp+8, esp);
+		f->eax=syscall_schedstat(*(int *)(esp+4),*(struct sched_stat **)(esp+8),esp);
+		break;
   }
 }
@@ -1,8 +1,13 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+
+struct sched_stat;
+
 struct lock filesys_lock;
 int syscall_exec(const char *);
+bool syscall_schedstat(int, struct sched_stat *, void *esp);
 void syscall_exit(int);
 struct vm_entry *check_addr(void *, void *);
 void syscall_init (void);
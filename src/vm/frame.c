@@ -0,0 +1,351 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Frames that hold user pages, in clock order.  The clock hand
+   points to the next frame to examine, or to the list end,
+   from which it wraps around.  New frames are inserted just
+   behind the hand, so that they are examined last. */
+static struct list frame_list;
+static struct list_elem *clock_hand;
+static size_t frame_cnt;                /* Number of frames in the list. */
+static struct lock frame_lock;          /* Protects the above and frames. */
+static struct slab_cache frame_cache;   /* Allocates struct frame. */
+
+/* A page of zeros, shared read-only by every zero-fill page that
+   has been read but not yet written.  It is not in the frame
+   list, so it is never evicted. */
+static struct frame zero_frame;
+
+/* Statistics. */
+static size_t evict_cnt;                /* Frames evicted. */
+static size_t clean_cnt;                /* Evicted without writing. */
+static size_t zero_map_cnt;             /* Mappings of the zero frame. */
+
+static struct frame *alloc_frame (enum palloc_flags, struct vm_entry *,
+                                  bool may_evict);
+static void *evict_frame (void);
+static void write_back (struct frame *);
+static void *release_frame (struct frame *);
+static struct frame *clock_next (void);
+static void remove_frame (struct frame *);
+
+/* Initializes the frame table. */
+void
+frame_init (void) 
+{
+  list_init (&frame_list);
+  clock_hand = list_end (&frame_list);
+  lock_init_named (&frame_lock, "frame table");
+  slab_cache_init (&frame_cache, "frame", sizeof (struct frame),
+                   sizeof (void *), NULL);
+  zero_frame.kaddr = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  zero_frame.pinned = true;
+}
+
+/* Obtains a frame from the user pool to hold VME's page, on
+   behalf of the running process, evicting some other page if
+   the pool is empty.  If FLAGS includes PAL_ZERO, the frame is
+   zeroed.  Returns the frame, pinned so that it cannot be
+   evicted before the caller maps it and calls frame_unpin(),
+   or a null pointer if no frame can be found. */
+struct frame *
+frame_alloc (enum palloc_flags flags, struct vm_entry *vme) 
+{
+  return alloc_frame (flags, vme, true);
+}
+
+/* Like frame_alloc(), but only takes a free frame, never
+   evicting a page.  For speculative uses. */
+struct frame *
+frame_try_alloc (enum palloc_flags flags, struct vm_entry *vme) 
+{
+  return alloc_frame (flags, vme, false);
+}
+
+/* Makes F, which frame_alloc() returned pinned, eligible for
+   eviction. */
+void
+frame_unpin (struct frame *f) 
+{
+  f->pinned = false;
+}
+
+/* If VME's page is in a frame, unmaps it from its owner's page
+   directory and frees the frame, first writing the page back if
+   it belongs to a memory-mapped file and is dirty.  The shared
+   zero frame is only unmapped, which must be done by VME's
+   owner. */
+void
+frame_free (struct vm_entry *vme) 
+{
+  struct frame *f;
+
+  if (frame_is_zero (vme->frame)) 
+    {
+      pagedir_clear_page (thread_current ()->pagedir, vme->vaddr);
+      vme->frame = NULL;
+      vme->is_loaded = false;
+      return;
+    }
+
+  lock_acquire (&frame_lock);
+  f = vme->frame;
+  if (f != NULL)
+    {
+      uint32_t *pd = f->owner->pagedir;
+
+      pagedir_clear_page (pd, vme->vaddr);
+      if (vme->type == VM_FILE && vme->is_loaded
+          && pagedir_is_dirty (pd, vme->vaddr))
+        write_back (f);
+      remove_frame (f);
+      palloc_free_page (f->kaddr);
+      slab_free (&frame_cache, f);
+      vme->frame = NULL;
+      vme->is_loaded = false;
+    }
+  lock_release (&frame_lock);
+}
+
+/* If VME is a zero-fill page that has no frame and has never
+   been swapped out, maps the shared zero frame read-only at its
+   page in the running process, which must own VME, and returns
+   true.  Otherwise, or if memory for a page table is not
+   available, returns false, and the caller should bring the page
+   in as usual.
+
+   The test is made under frame_lock because another process may
+   be evicting VME's page: evict_frame() unmaps the page but sets
+   its swap slot and clears its frame only after the write. */
+bool
+frame_map_zero (struct vm_entry *vme) 
+{
+  uint32_t *pd = thread_current ()->pagedir;
+  bool success = false;
+
+  lock_acquire (&frame_lock);
+  if (vme->type == VM_ANON && vme->frame == NULL
+      && vme->swap_slot == SWAP_ERROR
+      && pagedir_set_page (pd, vme->vaddr, zero_frame.kaddr, false)) 
+    {
+      vme->frame = &zero_frame;
+      vme->is_loaded = true;
+      zero_map_cnt++;
+      success = true;
+    }
+  lock_release (&frame_lock);
+  return success;
+}
+
+/* Returns true if F is the shared zero frame. */
+bool
+frame_is_zero (const struct frame *f) 
+{
+  return f == &zero_frame;
+}
+
+/* Prints frame table statistics. */
+void
+frame_print_stats (void) 
+{
+  printf ("Frames: %zu in use, %zu evicted (%zu clean), "
+          "%zu zero-page mappings\n",
+          frame_cnt, evict_cnt, clean_cnt, zero_map_cnt);
+}
+
+/* Obtains a frame for VME, as frame_alloc(), evicting a page
+   only if MAY_EVICT is true. */
+static struct frame *
+alloc_frame (enum palloc_flags flags, struct vm_entry *vme, bool may_evict) 
+{
+  struct frame *f;
+  void *kaddr;
+
+  f = slab_alloc (&frame_cache);
+  if (f == NULL)
+    return NULL;
+
+  lock_acquire (&frame_lock);
+  kaddr = palloc_get_page (PAL_USER | flags);
+  if (kaddr == NULL && may_evict)
+    {
+      kaddr = evict_frame ();
+      if (kaddr != NULL && (flags & PAL_ZERO))
+        memset (kaddr, 0, PGSIZE);
+    }
+  if (kaddr == NULL)
+    {
+      lock_release (&frame_lock);
+      slab_free (&frame_cache, f);
+      return NULL;
+    }
+
+  f->kaddr = kaddr;
+  f->owner = thread_current ();
+  f->vme = vme;
+  f->pinned = true;
+  list_insert (clock_hand, &f->elem);
+  frame_cnt++;
+  vme->frame = f;
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Chooses unpinned frames with the clock algorithm, saves the
+   pages they hold, and returns the kernel address of one of the
+   frames for reuse.  A page that was accessed since the hand last
+   passed it gets a second chance.
+
+   A clean executable page is simply dropped, since it can be
+   read again, and a dirty memory-mapped page is written back to
+   its file; either ends the scan.  Other pages need swap.  Those
+   are gathered into a batch of up to SWAP_BATCH pages of the
+   same process, which swap_out() writes to consecutive slots in
+   one request, and the frames not reused go back to the user
+   pool for the faults that follow.
+
+   Returns a null pointer if every frame is pinned.  frame_lock
+   must be held. */
+static void *
+evict_frame (void) 
+{
+  struct frame *batch[SWAP_BATCH];
+  size_t batch_cnt = 0;
+  void *kaddr = NULL;
+  size_t scan_cnt;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* Two sweeps reach a frame whose accessed bit the first sweep
+     cleared, unless every frame is pinned. */
+  for (scan_cnt = 2 * frame_cnt;
+       scan_cnt > 0 && kaddr == NULL && batch_cnt < SWAP_BATCH
+         && !list_empty (&frame_list);
+       scan_cnt--)
+    {
+      struct frame *f = clock_next ();
+      struct vm_entry *vme = f->vme;
+      uint32_t *pd = f->owner->pagedir;
+      bool dirty;
+
+      if (f->pinned || (batch_cnt > 0 && f->owner != batch[0]->owner))
+        continue;
+      if (pagedir_is_accessed (pd, vme->vaddr)) 
+        {
+          pagedir_set_accessed (pd, vme->vaddr, false);
+          continue;
+        }
+
+      /* Unmap the page before saving it, so that its owner faults
+         and waits for frame_lock instead of modifying the page
+         while it is written.  The dirty bit survives unmapping. */
+      pagedir_clear_page (pd, vme->vaddr);
+      dirty = pagedir_is_dirty (pd, vme->vaddr);
+      remove_frame (f);
+      if (vme->type == VM_ANON || (vme->type == VM_BIN && dirty))
+        batch[batch_cnt++] = f;
+      else 
+        {
+          if (dirty)
+            write_back (f);
+          else
+            clean_cnt++;
+          kaddr = release_frame (f);
+        }
+    }
+
+  if (batch_cnt > 0) 
+    {
+      void *pages[SWAP_BATCH];
+      size_t slots[SWAP_BATCH];
+      size_t i;
+
+      for (i = 0; i < batch_cnt; i++)
+        pages[i] = batch[i]->kaddr;
+      if (!swap_out (pages, batch_cnt, batch[0]->owner->tid, slots))
+        PANIC ("out of swap space");
+
+      for (i = 0; i < batch_cnt; i++) 
+        {
+          struct vm_entry *vme = batch[i]->vme;
+          void *page;
+
+          /* The file, if any, no longer has the page's contents. */
+          vme->type = VM_ANON;
+          vme->swap_slot = slots[i];
+          page = release_frame (batch[i]);
+          if (kaddr == NULL)
+            kaddr = page;
+          else
+            palloc_free_page (page);
+        }
+    }
+  return kaddr;
+}
+
+/* Writes the memory-mapped page in F back to its file.
+
+   This does not take filesys_lock, and may not: eviction runs
+   inside page faults, including those taken by system calls that
+   already hold it.  None is needed, because the base file system
+   is safe to call this way.  The page lies within the file's
+   length, and file_write_at() never extends a file, so only the
+   file's existing sectors are written, and the block device
+   driver serializes its own requests.  load_file() reads pages
+   in without the lock for the same reason. */
+static void
+write_back (struct frame *f) 
+{
+  struct vm_entry *vme = f->vme;
+
+  file_write_at (vme->file, f->kaddr, vme->read_bytes, vme->offset);
+}
+
+/* Detaches F, which has been removed from the frame list, from
+   its page, frees it, and returns the kernel address of the
+   frame it described. */
+static void *
+release_frame (struct frame *f) 
+{
+  void *kaddr = f->kaddr;
+
+  f->vme->frame = NULL;
+  f->vme->is_loaded = false;
+  slab_free (&frame_cache, f);
+  evict_cnt++;
+  return kaddr;
+}
+
+/* Returns the frame under the clock hand and advances the hand.
+   The frame list must not be empty. */
+static struct frame *
+clock_next (void) 
+{
+  struct frame *f;
+
+  if (clock_hand == list_end (&frame_list))
+    clock_hand = list_begin (&frame_list);
+  f = list_entry (clock_hand, struct frame, elem);
+  clock_hand = list_next (clock_hand);
+  return f;
+}
+
+/* Removes F from the frame list, moving the clock hand past it
+   if necessary. */
+static void
+remove_frame (struct frame *f) 
+{
+  if (clock_hand == &f->elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->elem);
+  frame_cnt--;
+}
@@ -0,0 +1,29 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/palloc.h"
+
+struct vm_entry;
+
+/* A frame of the user pool that holds a page of some process. */
+struct frame
+  {
+    void *kaddr;                /* Kernel virtual address of the frame. */
+    struct thread *owner;       /* Process whose page it holds. */
+    struct vm_entry *vme;       /* The page it holds. */
+    bool pinned;                /* Exempt from eviction while true. */
+    struct list_elem elem;      /* Element in the clock list. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (enum palloc_flags, struct vm_entry *);
+struct frame *frame_try_alloc (enum palloc_flags, struct vm_entry *);
+void frame_unpin (struct frame *);
+void frame_free (struct vm_entry *);
+bool frame_map_zero (struct vm_entry *);
+bool frame_is_zero (const struct frame *);
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
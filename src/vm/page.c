@@ -0,0 +1,289 @@
+#include "vm/page.h"
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Allocates struct vm_entry. */
+static struct slab_cache vme_cache;
+
+static hash_hash_func vm_hash_func;
+static hash_less_func vm_less_func;
+static hash_action_func vm_destroy_func;
+static void unmap (struct mmap_file *);
+
+/* Initializes the vm_entry allocator. */
+void
+page_init (void) 
+{
+  slab_cache_init (&vme_cache, "vm_entry", sizeof (struct vm_entry),
+                   sizeof (void *), NULL);
+}
+
+/* Returns a new vm_entry of the given TYPE for the user page at
+   VADDR, with no frame or swap slot and no file data, or a null
+   pointer if memory is not available. */
+struct vm_entry *
+vme_create (uint8_t type, void *vaddr, bool writable) 
+{
+  struct vm_entry *vme = slab_alloc (&vme_cache);
+
+  if (vme == NULL)
+    return NULL;
+  memset (vme, 0, sizeof *vme);
+  vme->type = type;
+  vme->vaddr = vaddr;
+  vme->writable = writable;
+  vme->swap_slot = SWAP_ERROR;
+  return vme;
+}
+
+/* Frees VME, which is not in any vm table, along with its frame
+   or swap slot. */
+void
+vme_destroy (struct vm_entry *vme) 
+{
+  frame_free (vme);
+  if (vme->swap_slot != SWAP_ERROR)
+    swap_free (vme->swap_slot);
+  slab_free (&vme_cache, vme);
+}
+
+/* Initializes VM as an empty table of vm_entries. */
+void
+vm_init (struct hash *vm)
+{
+  hash_init (vm, vm_hash_func, vm_less_func, NULL);
+}
+
+/* Frees every vm_entry in VM, along with the frames and swap
+   slots that hold their pages.  Must be called before the
+   owner's page directory is destroyed. */
+void
+vm_destroy (struct hash *vm)
+{
+  hash_destroy (vm, vm_destroy_func);
+}
+
+/* Returns the current process's vm_entry for the page that
+   contains VADDR, or a null pointer if there is none. */
+struct vm_entry *
+find_vme (void *vaddr)
+{
+  struct vm_entry vme;
+  struct hash_elem *e;
+
+  vme.vaddr = pg_round_down (vaddr);
+  e = hash_find (&thread_current ()->vm, &vme.elem);
+  return e != NULL ? hash_entry (e, struct vm_entry, elem) : NULL;
+}
+
+/* Adds VME to VM.  Returns false if VM already has an entry for
+   the same page. */
+bool
+insert_vme (struct hash *vm, struct vm_entry *vme)
+{
+  return hash_insert (vm, &vme->elem) == NULL;
+}
+
+/* Removes VME from VM and frees it, along with its frame or
+   swap slot.  Returns false if VME was not in VM. */
+bool
+delete_vme (struct hash *vm, struct vm_entry *vme)
+{
+  if (hash_delete (vm, &vme->elem) == NULL)
+    return false;
+  vme_destroy (vme);
+  return true;
+}
+
+/* Reads the file-backed part of VME's page into the frame at
+   KADDR and zeroes the rest.  Returns true if successful. */
+bool
+load_file (void *kaddr, struct vm_entry *vme)
+{
+  if (file_read_at (vme->file, kaddr, vme->read_bytes, vme->offset)
+      != (int) vme->read_bytes)
+    return false;
+  memset ((uint8_t *) kaddr + vme->read_bytes, 0, vme->zero_bytes);
+  return true;
+}
+
+/* Maps FILE into the running process's address space starting at
+   ADDR, and returns the new mapping's identifier, or -1 on
+   failure.  The pages are read from a reopened copy of FILE when
+   they are first touched, so closing FILE does not affect the
+   mapping.  Fails if FILE is empty, if ADDR is null or not
+   page-aligned, or if any page would overlap an existing page or
+   the region reserved for stack growth. */
+int
+vm_mmap (struct file *file, void *addr) 
+{
+  struct thread *cur = thread_current ();
+  uint8_t *stack_bottom = (uint8_t *) PHYS_BASE - stack_limit;
+  struct mmap_file *mf;
+  off_t length;
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return -1;
+  length = file_length (file);
+  if (length == 0)
+    return -1;
+
+  mf = malloc (sizeof *mf);
+  if (mf == NULL)
+    return -1;
+  mf->addr = addr;
+  mf->page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  for (i = 0; i < mf->page_cnt; i++) 
+    {
+      uint8_t *upage = mf->addr + i * PGSIZE;
+      if (upage >= stack_bottom || find_vme (upage) != NULL) 
+        {
+          free (mf);
+          return -1;
+        }
+    }
+  mf->file = file_reopen (file);
+  if (mf->file == NULL) 
+    {
+      free (mf);
+      return -1;
+    }
+  mf->mapid = cur->next_mapid++;
+  list_push_back (&cur->mmap_list, &mf->elem);
+
+  for (i = 0; i < mf->page_cnt; i++) 
+    {
+      off_t ofs = i * PGSIZE;
+      struct vm_entry *vme = vme_create (VM_FILE, mf->addr + ofs, true);
+
+      if (vme == NULL) 
+        {
+          unmap (mf);
+          return -1;
+        }
+      vme->file = mf->file;
+      vme->offset = ofs;
+      vme->read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+      vme->zero_bytes = PGSIZE - vme->read_bytes;
+      insert_vme (&cur->vm, vme);
+    }
+  return mf->mapid;
+}
+
+/* Removes the running process's mapping MAPID, if it exists,
+   writing its dirty pages back to the file. */
+void
+vm_munmap (int mapid) 
+{
+  struct list *mmap_list = &thread_current ()->mmap_list;
+  struct list_elem *e;
+
+  for (e = list_begin (mmap_list); e != list_end (mmap_list);
+       e = list_next (e)) 
+    {
+      struct mmap_file *mf = list_entry (e, struct mmap_file, elem);
+      if (mf->mapid == mapid) 
+        {
+          unmap (mf);
+          return;
+        }
+    }
+}
+
+/* Removes all of the running process's mappings, writing their
+   dirty pages back.  Must be called before vm_destroy(). */
+void
+vm_munmap_all (void) 
+{
+  struct list *mmap_list = &thread_current ()->mmap_list;
+
+  while (!list_empty (mmap_list))
+    unmap (list_entry (list_front (mmap_list), struct mmap_file, elem));
+}
+
+/* Terminates the process unless every page of the SIZE-byte
+   BUFFER is part of its address space and, if TO_WRITE, is
+   writable. */
+void
+check_valid_buffer (void *buffer, unsigned size, void *esp, bool to_write)
+{
+  uint8_t *p = pg_round_down (buffer);
+  uint8_t *end = (uint8_t *) buffer + size;
+
+  for (; p < end; p += PGSIZE)
+    {
+      struct vm_entry *vme = check_addr (p, esp);
+      if (to_write && !vme->writable)
+        syscall_exit (-1);
+    }
+}
+
+/* Terminates the process unless every byte of null-terminated
+   string STR is part of its address space. */
+void
+check_valid_string (const void *str, void *esp)
+{
+  const char *p = str;
+
+  check_addr ((void *) p, esp);
+  while (*p != '\0')
+    {
+      p++;
+      if (pg_ofs (p) == 0)
+        check_addr ((void *) p, esp);
+    }
+}
+
+/* Removes mapping MF from the running process and frees it.
+   Freeing each page's frame writes the page back if it is
+   dirty. */
+static void
+unmap (struct mmap_file *mf) 
+{
+  struct hash *vm = &thread_current ()->vm;
+  size_t i;
+
+  for (i = 0; i < mf->page_cnt; i++) 
+    {
+      struct vm_entry *vme = find_vme (mf->addr + i * PGSIZE);
+      if (vme != NULL)
+        delete_vme (vm, vme);
+    }
+  list_remove (&mf->elem);
+  file_close (mf->file);
+  free (mf);
+}
+
+/* Returns a hash value for the vm_entry that contains E. */
+static unsigned
+vm_hash_func (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct vm_entry *vme = hash_entry (e, struct vm_entry, elem);
+  return hash_int ((int) vme->vaddr);
+}
+
+/* Returns true if the vm_entry that contains A has a lower user
+   address than the one that contains B. */
+static bool
+vm_less_func (const struct hash_elem *a, const struct hash_elem *b,
+              void *aux UNUSED)
+{
+  return (hash_entry (a, struct vm_entry, elem)->vaddr
+          < hash_entry (b, struct vm_entry, elem)->vaddr);
+}
+
+/* Frees the vm_entry that contains E. */
+static void
+vm_destroy_func (struct hash_elem *e, void *aux UNUSED)
+{
+  vme_destroy (hash_entry (e, struct vm_entry, elem));
+}
@@ -0,0 +1,61 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/file.h"
+
+struct frame;
+
+/* Kinds of virtual pages. */
+#define VM_BIN 0                /* Loaded from the executable. */
+#define VM_FILE 1               /* Loaded from a memory-mapped file. */
+#define VM_ANON 2               /* Anonymous, not backed by a file. */
+
+/* One page of a process's virtual address space. */
+struct vm_entry
+  {
+    uint8_t type;               /* VM_BIN, VM_FILE, or VM_ANON. */
+    void *vaddr;                /* User virtual page address. */
+    bool writable;              /* Whether the page may be written. */
+    bool is_loaded;             /* Whether a frame is mapped. */
+    struct file *file;          /* Backing file, for VM_BIN and VM_FILE. */
+    size_t offset;              /* Offset of page data within FILE. */
+    size_t read_bytes;          /* Bytes of page data read from FILE. */
+    size_t zero_bytes;          /* Remaining bytes, which are zeroed. */
+    struct frame *frame;        /* Frame holding the page, if loaded. */
+    size_t swap_slot;           /* Swap slot holding the page, or
+                                   SWAP_ERROR. */
+    struct hash_elem elem;      /* Element in the owner's `vm' table. */
+  };
+
+/* A memory-mapped file. */
+struct mmap_file
+  {
+    int mapid;                  /* Mapping identifier. */
+    struct file *file;          /* Reopened file backing the pages. */
+    uint8_t *addr;              /* First mapped user page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+    struct list_elem elem;      /* Element in the owner's mmap_list. */
+  };
+
+void page_init (void);
+struct vm_entry *vme_create (uint8_t type, void *vaddr, bool writable);
+void vme_destroy (struct vm_entry *);
+void vm_init (struct hash *);
+void vm_destroy (struct hash *);
+struct vm_entry *find_vme (void *vaddr);
+bool insert_vme (struct hash *, struct vm_entry *);
+bool delete_vme (struct hash *, struct vm_entry *);
+bool load_file (void *kaddr, struct vm_entry *);
+int vm_mmap (struct file *, void *addr);
+void vm_munmap (int mapid);
+void vm_munmap_all (void);
+void check_valid_buffer (void *buffer, unsigned size, void *esp,
+                         bool to_write);
+void check_valid_string (const void *str, void *esp);
+
+#endif /* vm/page.h */
@@ -0,0 +1,210 @@
+#include "vm/swap.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Number of sectors in a swap slot, which holds one page. */
+#define SLOT_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block *swap_block;  /* Swap device, if any. */
+static struct bitmap *used_map;   /* Slots in use, one bit per slot. */
+static tid_t *slot_owner;         /* Process whose page each slot holds. */
+static struct lock swap_lock;     /* Protects everything in this file. */
+
+/* Staging area for writing a batch of pages as one run. */
+static uint8_t *write_buf;
+
+/* Read-around cache: copies of up to SWAP_BATCH consecutive slots
+   starting at RA_FIRST, read in one request.  The copy of a slot
+   is valid until the slot is freed. */
+static uint8_t *ra_buf;
+static size_t ra_first;
+static bool ra_valid[SWAP_BATCH];
+
+/* Statistics. */
+static size_t batch_cnts[SWAP_BATCH];   /* Batches of 1...SWAP_BATCH pages. */
+static size_t out_cnt, write_cnt;       /* Pages written, write requests. */
+static size_t in_cnt, read_cnt;         /* Pages read, read requests. */
+static size_t ra_hit_cnt;               /* Pages found in read-around cache. */
+
+static bool same_owner (size_t slot, tid_t owner);
+static void read_around (size_t slot);
+static bool is_cached (size_t slot);
+static void release_slot (size_t slot);
+
+/* Initializes the swap slot table on the BLOCK_SWAP device.
+   Without a swap device, swap_out() always fails. */
+void
+swap_init (void) 
+{
+  size_t slot_cnt = 0;
+
+  lock_init_named (&swap_lock, "swap");
+  swap_block = block_get_role (BLOCK_SWAP);
+  if (swap_block != NULL)
+    slot_cnt = block_size (swap_block) / SLOT_SECTORS;
+  used_map = bitmap_create (slot_cnt);
+  if (used_map == NULL)
+    PANIC ("swap slot bitmap creation failed");
+  if (slot_cnt == 0)
+    return;
+
+  slot_owner = palloc_get_multiple (PAL_ASSERT,
+                                    DIV_ROUND_UP (slot_cnt * sizeof *slot_owner,
+                                                  PGSIZE));
+  write_buf = palloc_get_multiple (PAL_ASSERT, SWAP_BATCH);
+  ra_buf = palloc_get_multiple (PAL_ASSERT, SWAP_BATCH);
+}
+
+/* Writes the CNT pages in PAGES, which belong to process OWNER,
+   to swap, and stores the slot used for each page in SLOTS.
+   CNT must be between 1 and SWAP_BATCH.  The pages are given
+   consecutive slots and written with one request if there is a
+   long enough run of free slots, otherwise in as few runs as
+   possible.  Returns false if swap is full, in which case some
+   of the pages may have been written anyway. */
+bool
+swap_out (void *pages[], size_t cnt, tid_t owner, size_t slots[]) 
+{
+  size_t done;
+
+  ASSERT (cnt >= 1 && cnt <= SWAP_BATCH);
+
+  lock_acquire (&swap_lock);
+  for (done = 0; done < cnt; ) 
+    {
+      size_t n = cnt - done;
+      size_t first, i;
+
+      while ((first = bitmap_scan_and_flip (used_map, 0, n, false))
+             == BITMAP_ERROR)
+        if (--n == 0) 
+          {
+            lock_release (&swap_lock);
+            return false;
+          }
+
+      for (i = 0; i < n; i++) 
+        {
+          slots[done + i] = first + i;
+          slot_owner[first + i] = owner;
+          if (n > 1)
+            memcpy (write_buf + i * PGSIZE, pages[done + i], PGSIZE);
+        }
+      block_write_multiple (swap_block, first * SLOT_SECTORS,
+                            n * SLOT_SECTORS,
+                            n > 1 ? write_buf : pages[done]);
+      write_cnt++;
+      done += n;
+    }
+  out_cnt += cnt;
+  batch_cnts[cnt - 1]++;
+  lock_release (&swap_lock);
+  return true;
+}
+
+/* Reads swap slot SLOT into the page at KADDR and frees the
+   slot.  If the slot is not in the read-around cache, the slots
+   next to it that hold pages of the same process are read along
+   with it, so that faults on those pages need no disk access. */
+void
+swap_in (size_t slot, void *kaddr) 
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_map, slot));
+  if (is_cached (slot))
+    ra_hit_cnt++;
+  else
+    read_around (slot);
+  memcpy (kaddr, ra_buf + (slot - ra_first) * PGSIZE, PGSIZE);
+  release_slot (slot);
+  in_cnt++;
+  lock_release (&swap_lock);
+}
+
+/* Frees swap slot SLOT without reading it. */
+void
+swap_free (size_t slot) 
+{
+  lock_acquire (&swap_lock);
+  release_slot (slot);
+  lock_release (&swap_lock);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void) 
+{
+  size_t i;
+
+  if (swap_block == NULL)
+    return;
+  printf ("Swap: %zu of %zu slots in use, "
+          "%zu pages out in %zu writes, %zu pages in in %zu reads, "
+          "%zu read-around hits\n",
+          bitmap_count (used_map, 0, bitmap_size (used_map), true),
+          bitmap_size (used_map), out_cnt, write_cnt, in_cnt, read_cnt,
+          ra_hit_cnt);
+  printf ("Swap batches by page count:");
+  for (i = 0; i < SWAP_BATCH; i++)
+    printf (" %zu:%zu", i + 1, batch_cnts[i]);
+  printf ("\n");
+}
+
+/* Returns true if SLOT belongs to process OWNER. */
+static bool
+same_owner (size_t slot, tid_t owner) 
+{
+  return bitmap_test (used_map, slot) && slot_owner[slot] == owner;
+}
+
+/* Reads SLOT and up to SWAP_BATCH - 1 neighbouring slots that
+   belong to the same process into the read-around cache, with
+   one request.  Slots after SLOT are preferred, since batches
+   are gathered in clock order, which follows the order in which
+   the pages were faulted in. */
+static void
+read_around (size_t slot) 
+{
+  tid_t owner = slot_owner[slot];
+  size_t first = slot;
+  size_t last = slot + 1;
+  size_t i;
+
+  while (last - first < SWAP_BATCH && last < bitmap_size (used_map)
+         && same_owner (last, owner))
+    last++;
+  while (last - first < SWAP_BATCH && first > 0
+         && same_owner (first - 1, owner))
+    first--;
+
+  block_read_multiple (swap_block, first * SLOT_SECTORS,
+                       (last - first) * SLOT_SECTORS, ra_buf);
+  read_cnt++;
+  ra_first = first;
+  for (i = 0; i < SWAP_BATCH; i++)
+    ra_valid[i] = i < last - first;
+}
+
+/* Returns true if the read-around cache holds a copy of SLOT. */
+static bool
+is_cached (size_t slot) 
+{
+  return (slot >= ra_first && slot - ra_first < SWAP_BATCH
+          && ra_valid[slot - ra_first]);
+}
+
+/* Marks SLOT free and drops any cached copy of it. */
+static void
+release_slot (size_t slot) 
+{
+  ASSERT (bitmap_test (used_map, slot));
+  bitmap_reset (used_map, slot);
+  if (is_cached (slot))
+    ra_valid[slot - ra_first] = false;
+}
@@ -0,0 +1,22 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <bitmap.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/thread.h"
+
+/* Slot number that refers to no swap slot. */
+#define SWAP_ERROR BITMAP_ERROR
+
+/* Maximum number of pages written, or read around, in one
+   request. */
+#define SWAP_BATCH 8
+
+void swap_init (void);
+bool swap_out (void *pages[], size_t cnt, tid_t owner, size_t slots[]);
+void swap_in (size_t slot, void *kaddr);
+void swap_free (size_t slot);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */